@@ -0,0 +1,137 @@
+/*
+ * File:   BankCatalog.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "BankCatalog.h"
+#include "Log.h"
+
+BankCatalog::BankCatalog() {
+    MetricsRegistry &m = metrics();
+    metricBanks = m.gauge("modmidi_catalog_banks", "Banks on the Mod");
+    metricLoaded = m.gauge("modmidi_catalog_banks_loaded", "Banks whose pedalboards are in the catalog");
+}
+
+BankCatalog::~BankCatalog() {
+}
+
+// called with m_banks held
+void BankCatalog::updateGauge() {
+    int loaded = 0;
+    for (auto &b : banks) {
+        if (b.loaded) loaded++;
+    }
+    metricBanks->set(banks.size());
+    metricLoaded->set(loaded);
+}
+
+bool BankCatalog::refresh(int socket, std::mutex *socket_mutex) {
+    std::vector<ModBank> bankList;
+    int current;
+    if (!getBankList(socket, socket_mutex, bankList, current)) return false;
+    int fetch = -1;
+    {
+        std::lock_guard<std::mutex> guard(m_banks);
+        // keep what we have for banks that look the same
+        std::vector<Bank> updated;
+        for (auto &mb : bankList) {
+            Bank b;
+            b.bank = mb;
+            for (auto &old : banks) {
+                if (old.bank.id == mb.id && old.bank.title == mb.title && old.bank.count == mb.count) {
+                    b.pedalboards = old.pedalboards;
+                    b.loaded = old.loaded;
+                    break;
+                }
+            }
+            updated.push_back(b);
+        }
+        banks = updated;
+        currentBank = current;
+        // new & changed banks first, then the oldest
+        for (auto &b : banks) {
+            if (!b.loaded) {
+                fetch = b.bank.id;
+                break;
+            }
+        }
+        if (fetch < 0 && banks.size() > 0) {
+            if (nextStale >= banks.size()) nextStale = 0;
+            fetch = banks[nextStale++].bank.id;
+        }
+        updateGauge();
+    }
+    if (fetch < 0) return true;
+    std::vector<ModPedalboard> pedalboardList;
+    if (!getPedalboardList(socket, socket_mutex, pedalboardList, NULL, fetch)) return false;
+    std::lock_guard<std::mutex> guard(m_banks);
+    for (auto &b : banks) {
+        if (b.bank.id != fetch) continue;
+        LOG_DEBUG("bank catalog: %s has %u pedalboards", b.bank.title.c_str(), (unsigned int)pedalboardList.size());
+        b.pedalboards = pedalboardList;
+        b.loaded = true;
+    }
+    updateGauge();
+    return true;
+}
+
+void BankCatalog::setBanks(const std::vector<ModBank> &bankList, const std::vector<std::vector<ModPedalboard>> &pedalboardLists, int currentBank) {
+    std::lock_guard<std::mutex> guard(m_banks);
+    banks.clear();
+    for (size_t i=0; i<bankList.size() && i<pedalboardLists.size(); i++) {
+        Bank b;
+        b.bank = bankList[i];
+        b.pedalboards = pedalboardLists[i];
+        b.loaded = true;
+        banks.push_back(b);
+    }
+    this->currentBank = currentBank;
+    updateGauge();
+}
+
+bool BankCatalog::isComplete() {
+    std::lock_guard<std::mutex> guard(m_banks);
+    for (auto &b : banks) {
+        if (!b.loaded) return false;
+    }
+    return true;
+}
+
+int BankCatalog::getCurrentBank() {
+    std::lock_guard<std::mutex> guard(m_banks);
+    return currentBank;
+}
+
+bool BankCatalog::next(int bankId, int direction, int &nextId, std::vector<ModPedalboard> &pedalboardList) {
+    std::lock_guard<std::mutex> guard(m_banks);
+    size_t start = banks.size();
+    for (size_t i=0; i<banks.size(); i++) {
+        if (banks[i].bank.id == bankId) {
+            start = i;
+            break;
+        }
+    }
+    if (start == banks.size()) return false;
+    // skip empty banks & ones we don't know the pedalboards of yet
+    for (size_t n=1; n<=banks.size(); n++) {
+        size_t step = direction < 0 ? banks.size() - n : n;
+        const Bank &b = banks[(start + step) % banks.size()];
+        if (!b.loaded || b.pedalboards.size() == 0) continue;
+        nextId = b.bank.id;
+        pedalboardList = b.pedalboards;
+        return true;
+    }
+    return false;
+}
+
+bool BankCatalog::find(int bankId, std::vector<ModPedalboard> &pedalboardList) {
+    std::lock_guard<std::mutex> guard(m_banks);
+    for (auto &b : banks) {
+        if (b.bank.id != bankId || !b.loaded) continue;
+        pedalboardList = b.pedalboards;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,55 @@
+/*
+ * File:   BankCatalog.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef BANKCATALOG_H
+#define BANKCATALOG_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "Utilities.h"
+#include "Metrics.h"
+
+// Every bank on the Mod and its pedalboards, so the controller can flip
+// through banks straight away without waiting on the Mod. refresh() gets the
+// bank list and then at most one bank's pedalboards, so the catalog fills in
+// (and later stays current) a little at a time from the background.
+// this class is thread safe
+class BankCatalog {
+public:
+    BankCatalog();
+    virtual ~BankCatalog();
+    // returns false if the Mod didn't answer, the catalog keeps what it had
+    bool refresh(int socket, std::mutex *socket_mutex);
+    // replace the whole catalog, for simulate mode
+    void setBanks(const std::vector<ModBank> &bankList, const std::vector<std::vector<ModPedalboard>> &pedalboardLists, int currentBank);
+    // true once every bank's pedalboards are known
+    bool isComplete();
+    // the bank the Mod says is current, -1 if unknown
+    int getCurrentBank();
+    // the bank after bankId (or before it if direction < 0) that has
+    // pedalboards, wrapping around at the ends
+    bool next(int bankId, int direction, int &nextId, std::vector<ModPedalboard> &pedalboardList);
+    bool find(int bankId, std::vector<ModPedalboard> &pedalboardList);
+private:
+    class Bank {
+    public:
+        ModBank bank;
+        std::vector<ModPedalboard> pedalboards;
+        bool loaded = false;
+    };
+    void updateGauge();
+    std::mutex m_banks;
+    std::vector<Bank> banks;
+    int currentBank = -1;
+    // once everything is loaded, banks are fetched again in turn
+    size_t nextStale = 0;
+    Gauge *metricBanks, *metricLoaded;
+};
+
+#endif /* BANKCATALOG_H */
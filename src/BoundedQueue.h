@@ -0,0 +1,115 @@
+/*
+ * File:   BoundedQueue.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <string>
+
+#include "Metrics.h"
+#include "Clock.h"
+
+// Fixed size FIFO used between pipeline stages. All storage is allocated up
+// front so pushing and popping never allocate, but it isn't lock free: every
+// call takes a short mutex, so a realtime caller can still be held up by the
+// other side for as long as one push or pop takes. When it's full the
+// overflow policy decides whether the oldest item or the new one is dropped,
+// and items can be given a maximum age so a stalled consumer doesn't replay a
+// stale backlog later.
+// this class is thread safe
+template <typename T>
+class BoundedQueue {
+public:
+    enum OverflowPolicy {
+        DROP_OLDEST,
+        REJECT
+    };
+    BoundedQueue(std::string stage, size_t capacity, OverflowPolicy policy);
+    // returns false if the item was rejected
+    bool push(const T &item);
+    // skips & counts items older than maxAge, a zero maxAge disables the check
+    bool pop(T &item, std::chrono::milliseconds maxAge = std::chrono::milliseconds(0));
+    size_t size();
+    bool empty();
+private:
+    class Slot {
+    public:
+        T item;
+        std::chrono::steady_clock::time_point queued;
+    };
+    std::mutex m_slots;
+    std::vector<Slot> slots;
+    size_t head = 0, count = 0;
+    OverflowPolicy policy;
+    Gauge *metricDepth;
+    Counter *metricDropped, *metricExpired;
+};
+
+template <typename T>
+BoundedQueue<T>::BoundedQueue(std::string stage, size_t capacity, OverflowPolicy policy) : slots(capacity) {
+    this->policy = policy;
+    std::string labels = "stage=\"" + stage + "\"";
+    MetricsRegistry &m = metrics();
+    metricDepth = m.gauge("modmidi_pipeline_depth", "Items waiting in a pipeline stage", labels);
+    metricDropped = m.counter("modmidi_pipeline_dropped_total", "Items dropped because a pipeline stage was full", labels);
+    metricExpired = m.counter("modmidi_pipeline_expired_total", "Items dropped because they waited too long", labels);
+}
+
+template <typename T>
+bool BoundedQueue<T>::push(const T &item) {
+    auto now = currentClock().now();
+    std::lock_guard<std::mutex> guard(m_slots);
+    if (count == slots.size()) {
+        metricDropped->inc();
+        if (policy == REJECT) return false;
+        // overwrite the oldest item
+        head = (head + 1) % slots.size();
+        count--;
+    }
+    Slot &slot = slots[(head + count) % slots.size()];
+    slot.item = item;
+    slot.queued = now;
+    count++;
+    metricDepth->set(count);
+    return true;
+}
+
+template <typename T>
+bool BoundedQueue<T>::pop(T &item, std::chrono::milliseconds maxAge) {
+    auto now = currentClock().now();
+    std::lock_guard<std::mutex> guard(m_slots);
+    while (count > 0) {
+        Slot &slot = slots[head];
+        head = (head + 1) % slots.size();
+        count--;
+        metricDepth->set(count);
+        if (maxAge.count() > 0 && now - slot.queued > maxAge) {
+            metricExpired->inc();
+            continue;
+        }
+        item = slot.item;
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+size_t BoundedQueue<T>::size() {
+    std::lock_guard<std::mutex> guard(m_slots);
+    return count;
+}
+
+template <typename T>
+bool BoundedQueue<T>::empty() {
+    return size() == 0;
+}
+
+#endif /* BOUNDEDQUEUE_H */
+
@@ -0,0 +1,67 @@
+/*
+ * File:   Clock.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "Clock.h"
+
+#include <atomic>
+#include <thread>
+
+Clock::time_point SystemClock::now() {
+    return std::chrono::steady_clock::now();
+}
+
+void SystemClock::sleepFor(std::chrono::microseconds duration) {
+    std::this_thread::sleep_for(duration);
+}
+
+VirtualClock::VirtualClock() {
+    // start from the real time so anything stamped before the switch still
+    // looks like it's in the past
+    start = current = nextTick = std::chrono::steady_clock::now();
+}
+
+void VirtualClock::setTick(std::chrono::microseconds interval, std::function<void()> handler) {
+    tickInterval = interval;
+    tickHandler = handler;
+    nextTick = current + interval;
+}
+
+Clock::time_point VirtualClock::now() {
+    return current;
+}
+
+void VirtualClock::sleepFor(std::chrono::microseconds duration) {
+    time_point until = current + duration;
+    // a tick handler sleeping would only make time jump under it
+    if (inTick || !tickHandler || tickInterval.count() <= 0) {
+        current = until;
+        return;
+    }
+    while (nextTick <= until) {
+        current = nextTick;
+        nextTick += tickInterval;
+        inTick = true;
+        tickHandler();
+        inTick = false;
+    }
+    current = until;
+}
+
+std::chrono::microseconds VirtualClock::elapsed() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(current - start);
+}
+
+static SystemClock systemClock;
+static std::atomic<Clock*> activeClock{&systemClock};
+
+Clock &currentClock() {
+    return *activeClock.load(std::memory_order_relaxed);
+}
+
+void setCurrentClock(Clock *clock) {
+    activeClock.store(clock ? clock : &systemClock, std::memory_order_relaxed);
+}
@@ -0,0 +1,56 @@
+/*
+ * File:   Clock.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <chrono>
+#include <functional>
+
+// Where the worker & its helpers get the time and do their waiting, so a
+// simulated session can run on virtual time.
+class Clock {
+public:
+    typedef std::chrono::steady_clock::time_point time_point;
+    virtual ~Clock() {}
+    virtual time_point now() = 0;
+    virtual void sleepFor(std::chrono::microseconds duration) = 0;
+};
+
+// the real thing
+// this class is thread safe
+class SystemClock : public Clock {
+public:
+    time_point now();
+    void sleepFor(std::chrono::microseconds duration);
+};
+
+// Virtual time for simulated sessions. Sleeping moves time forward straight
+// away, calling the tick handler for every tick passed on the way, so the
+// simulated jack cycles keep running while the worker waits on the Mod.
+// only use this from a single thread
+class VirtualClock : public Clock {
+public:
+    VirtualClock();
+    void setTick(std::chrono::microseconds interval, std::function<void()> handler);
+    time_point now();
+    void sleepFor(std::chrono::microseconds duration);
+    // virtual time since the clock was created
+    std::chrono::microseconds elapsed();
+private:
+    time_point start, current, nextTick;
+    std::chrono::microseconds tickInterval{0};
+    std::function<void()> tickHandler;
+    bool inTick = false;
+};
+
+Clock &currentClock();
+// NULL goes back to the system clock
+void setCurrentClock(Clock *clock);
+
+#endif /* CLOCK_H */
+
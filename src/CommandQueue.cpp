@@ -0,0 +1,83 @@
+/*
+ * File:   CommandQueue.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "CommandQueue.h"
+#include "Log.h"
+#include "Clock.h"
+
+CommandQueue::CommandQueue() {
+    MetricsRegistry &m = metrics();
+    elidedPedalboards = m.counter("modmidi_commands_elided_total", "Commands dropped because a newer command replaced them", "command=\"load_pedalboard\"");
+    elidedPresets = m.counter("modmidi_commands_elided_total", "Commands dropped because a newer command replaced them", "command=\"load_preset\"");
+    depth = m.gauge("modmidi_pipeline_depth", "Items waiting in a pipeline stage", "stage=\"commands\"");
+    expired = m.counter("modmidi_pipeline_expired_total", "Items dropped because they waited too long", "stage=\"commands\"");
+}
+
+CommandQueue::~CommandQueue() {
+}
+
+// remove waiting commands of a type, called with m_commands held
+void CommandQueue::elide(ModCommand::Type type) {
+    for (auto i = commands.begin(); i != commands.end();) {
+        if (i->type == type) {
+            LOG_DEBUG("dropping %s %u, a newer command replaced it", type == ModCommand::LOAD_PEDALBOARD ? "load_pedalboard" : "load_preset", i->index);
+            if (type == ModCommand::LOAD_PEDALBOARD) {
+                elidedPedalboards->inc();
+            } else {
+                elidedPresets->inc();
+            }
+            i = commands.erase(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void CommandQueue::push(ModCommand command) {
+    command.queued = currentClock().now();
+    std::lock_guard<std::mutex> guard(m_commands);
+    elide(command.type);
+    if (command.type == ModCommand::LOAD_PEDALBOARD) elide(ModCommand::LOAD_PRESET);
+    commands.push_back(command);
+    depth->set(commands.size());
+}
+
+bool CommandQueue::pop(ModCommand &command, size_t *expiredCount) {
+    auto now = currentClock().now();
+    std::lock_guard<std::mutex> guard(m_commands);
+    while (commands.size() > 0) {
+        command = commands.front();
+        commands.pop_front();
+        depth->set(commands.size());
+        if (maxAge.count() > 0 && now - command.queued > maxAge) {
+            LOG_WARN("rejecting a command that waited too long for the Mod");
+            expired->inc();
+            if (expiredCount) (*expiredCount)++;
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+void CommandQueue::setMaxAge(std::chrono::milliseconds maxAge) {
+    std::lock_guard<std::mutex> guard(m_commands);
+    this->maxAge = maxAge;
+}
+
+bool CommandQueue::hasPending(ModCommand::Type type) {
+    std::lock_guard<std::mutex> guard(m_commands);
+    for (auto &c : commands) {
+        if (c.type == type) return true;
+    }
+    return false;
+}
+
+size_t CommandQueue::size() {
+    std::lock_guard<std::mutex> guard(m_commands);
+    return commands.size();
+}
@@ -0,0 +1,61 @@
+/*
+ * File:   CommandQueue.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <string>
+
+#include "Metrics.h"
+
+class ModCommand {
+public:
+    enum Type {
+        LOAD_PEDALBOARD,
+        LOAD_PRESET
+    };
+    Type type = LOAD_PEDALBOARD;
+    unsigned int index = 0;
+    // for pedalboards from a bank other than the Mod's current one, else -1
+    int bank = -1;
+    // the pedalboard to load, or the one the preset belongs to, followers
+    // find it in their own banks since their indexes can differ
+    std::string bundle;
+    std::chrono::steady_clock::time_point queued;
+};
+
+// Queue of commands waiting to be sent to the Mod. Only the newest command of
+// each type is kept, and a pedalboard load also drops any waiting preset load
+// since loading a pedalboard resets the preset. So scrolling through several
+// pedalboards quickly only loads the last one. Commands that waited longer
+// than maxAge (because the Mod stopped answering) are rejected instead of
+// being sent late.
+// this class is thread safe
+class CommandQueue {
+public:
+    CommandQueue();
+    virtual ~CommandQueue();
+    void push(ModCommand command);
+    // expired (if given) counts the commands that were rejected on the way
+    bool pop(ModCommand &command, size_t *expiredCount = NULL);
+    void setMaxAge(std::chrono::milliseconds maxAge);
+    bool hasPending(ModCommand::Type type);
+    size_t size();
+private:
+    void elide(ModCommand::Type type);
+    std::mutex m_commands;
+    std::deque<ModCommand> commands;
+    std::chrono::milliseconds maxAge{0};
+    Counter *elidedPedalboards, *elidedPresets, *expired;
+    Gauge *depth;
+};
+
+#endif /* COMMANDQUEUE_H */
+
@@ -0,0 +1,89 @@
+/*
+ * File:   CommandScheduler.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "CommandScheduler.h"
+
+#include <chrono>
+#include <string>
+#include <unistd.h>
+
+CommandScheduler::CommandScheduler() {
+    MetricsRegistry &m = metrics();
+    for (int i=0; i<PRIORITY_COUNT; i++) {
+        std::string labels = "class=\"" + std::string(priorityName((Priority)i)) + "\"";
+        lanes[i].metricWait = m.histogram("modmidi_scheduler_wait_us", "Time spent waiting for a turn to talk to the Mod", labels);
+        lanes[i].metricCommands = m.counter("modmidi_scheduler_jobs_total", "Jobs run by the command scheduler", labels);
+    }
+    metricYields = m.counter("modmidi_scheduler_yields_total", "Background jobs cut short for interactive work");
+}
+
+CommandScheduler::~CommandScheduler() {
+}
+
+const char *CommandScheduler::priorityName(Priority priority) {
+    switch(priority) {
+        case INTERACTIVE:
+            return "interactive";
+        case TEMPO:
+            return "tempo";
+        case PARAMETER:
+            return "parameter";
+        case BACKGROUND:
+        default:
+            return "background";
+    }
+}
+
+void CommandScheduler::setSocket(Priority priority, int socket) {
+    lanes[priority].socket = socket;
+}
+
+int CommandScheduler::getSocket(Priority priority) {
+    return lanes[priority].socket;
+}
+
+std::mutex *CommandScheduler::getSocketMutex(Priority priority) {
+    return &lanes[priority].m_socket;
+}
+
+void CommandScheduler::closeSockets() {
+    for (auto &lane : lanes) {
+        std::lock_guard<std::mutex> guard(lane.m_socket);
+        if (lane.socket >= 0) close(lane.socket);
+        lane.socket = -1;
+    }
+}
+
+void CommandScheduler::acquire(Priority priority) {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_lanes);
+    if (priority == BACKGROUND) {
+        // defer until there's no interactive work left
+        c_lanes.wait(lock, [this] {return lanes[INTERACTIVE].active == 0;});
+    }
+    lanes[priority].active++;
+    lock.unlock();
+    auto end = std::chrono::steady_clock::now();
+    lanes[priority].metricCommands->inc();
+    lanes[priority].metricWait->observe(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
+
+void CommandScheduler::release(Priority priority) {
+    {
+        std::lock_guard<std::mutex> guard(m_lanes);
+        if (lanes[priority].active > 0) lanes[priority].active--;
+    }
+    c_lanes.notify_all();
+}
+
+bool CommandScheduler::shouldYield(Priority priority) {
+    if (priority != BACKGROUND) return false;
+    std::lock_guard<std::mutex> guard(m_lanes);
+    if (lanes[INTERACTIVE].active == 0) return false;
+    metricYields->inc();
+    return true;
+}
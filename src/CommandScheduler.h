@@ -0,0 +1,62 @@
+/*
+ * File:   CommandScheduler.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include <mutex>
+#include <condition_variable>
+
+#include "Metrics.h"
+
+// Every priority class gets its own connection to the Mod (a lane), so a
+// footswitch press never queues behind a status poll on the same socket.
+// On top of that, background work waits while interactive work is queued or
+// running, and long background jobs should check shouldYield() between
+// commands so they can be cut short.
+// this class is thread safe
+class CommandScheduler {
+public:
+    enum Priority {
+        INTERACTIVE = 0,
+        TEMPO,
+        PARAMETER,
+        BACKGROUND,
+        PRIORITY_COUNT
+    };
+    CommandScheduler();
+    virtual ~CommandScheduler();
+    
+    void setSocket(Priority priority, int socket);
+    int getSocket(Priority priority);
+    std::mutex *getSocketMutex(Priority priority);
+    void closeSockets();
+    
+    // wait for our turn, every acquire() needs a matching release()
+    void acquire(Priority priority);
+    void release(Priority priority);
+    bool shouldYield(Priority priority);
+    
+    static const char *priorityName(Priority priority);
+private:
+    class Lane {
+    public:
+        int socket = -1;
+        std::mutex m_socket;
+        // commands of this class that are waiting or running
+        unsigned int active = 0;
+        Histogram *metricWait;
+        Counter *metricCommands;
+    };
+    Lane lanes[PRIORITY_COUNT];
+    std::mutex m_lanes;
+    std::condition_variable c_lanes;
+    Counter *metricYields;
+};
+
+#endif /* COMMANDSCHEDULER_H */
+
@@ -0,0 +1,274 @@
+/*
+ * File:   Controller.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "Controller.h"
+#include "FlightRecorder.h"
+
+#include <jack/midiport.h>
+#include <string.h>
+
+static const size_t OUTPUT_QUEUE_SIZE = 256;
+// more than all the FCB1010's lights at once
+static const size_t LIGHT_BACKLOG_SIZE = 64;
+
+Controller::Controller(std::string name, jack_port_t *inputPort, jack_port_t *outputPort, const DeviceProfile &profile)
+        : outputEvents("midi_output:" + name, OUTPUT_QUEUE_SIZE, BoundedQueue<MidiEvent>::REJECT), cycleEvents(OUTPUT_QUEUE_SIZE), lightEvents(LIGHT_BACKLOG_SIZE) {
+    this->name = name;
+    this->inputPort = inputPort;
+    this->outputPort = outputPort;
+    gestures.setProfile(profile);
+    this->profile = profile;
+    std::string labels = "controller=\"" + name + "\"";
+    MetricsRegistry &m = metrics();
+    metricThru = m.counter("modmidi_thru_events_total", "Input events passed straight through to the output", labels);
+    metricThruBudget = m.counter("modmidi_thru_dropped_total", "Thru events dropped because the cycle's budget was used up", labels);
+    metricOutputFull = m.counter("modmidi_output_full_total", "Output events dropped because jack's buffer was full", labels);
+    metricCarried = m.counter("modmidi_output_carried_total", "Light messages carried over to the next cycle for lack of link bandwidth", labels);
+    metricLightDelay = m.histogram("modmidi_output_light_delay_us", "Time light messages waited for room on the link", labels);
+    metricBytes = m.counter("modmidi_output_bytes_total", "Bytes written to the controller", labels);
+    metricBytesSaved = m.counter("modmidi_output_bytes_saved_total", "Status bytes left out thanks to running status", labels);
+    metricBacklog = m.gauge("modmidi_output_link_backlog_bytes", "Bytes given to the link that it hasn't sent yet", labels);
+}
+
+Controller::~Controller() {
+}
+
+std::string Controller::getName() {
+    return name;
+}
+
+jack_port_t *Controller::getInputPort() {
+    return inputPort;
+}
+
+jack_port_t *Controller::getOutputPort() {
+    return outputPort;
+}
+
+const DeviceProfile &Controller::getProfile() {
+    return profile;
+}
+
+bool Controller::hasLights() {
+    return profile.hasLights;
+}
+
+FCBLights &Controller::getLights() {
+    return lights;
+}
+
+GestureEngine &Controller::getGestures() {
+    return gestures;
+}
+
+void Controller::setThru(const ThruFilter &filter, unsigned int budget) {
+    thru = filter;
+    thruBudget = budget;
+}
+
+void Controller::setLinkRate(unsigned int bytesPerSecond, jack_nframes_t sampleRate) {
+    this->sampleRate = sampleRate;
+    shaper.setRate(bytesPerSecond, sampleRate);
+}
+
+void Controller::setRunningStatus(bool enabled, int resyncMsec, jack_nframes_t sampleRate) {
+    encoder.setEnabled(enabled);
+    encoder.setResyncInterval((uint64_t)resyncMsec * sampleRate / 1000);
+}
+
+void Controller::resync() {
+    encoder.requestResync();
+}
+
+void Controller::updateLatency(jack_latency_callback_mode_t mode) {
+    jack_latency_range_t range;
+    if (mode == JackCaptureLatency) {
+        // how long ago whatever we read was played on the controller
+        jack_port_get_latency_range(inputPort, JackCaptureLatency, &range);
+        jack_port_set_latency_range(outputPort, JackCaptureLatency, &range);
+        captureLatency = range.max;
+    } else {
+        // how long until whatever we write reaches the controller
+        jack_port_get_latency_range(outputPort, JackPlaybackLatency, &range);
+        jack_port_set_latency_range(inputPort, JackPlaybackLatency, &range);
+        playbackLatency = range.max;
+    }
+}
+
+jack_nframes_t Controller::getRoundTripLatency() {
+    return captureLatency + playbackLatency;
+}
+
+jack_nframes_t Controller::beginCycle(jack_nframes_t nframes) {
+    inputBuffer = jack_port_get_buffer(inputPort, nframes);
+    inputCount = jack_midi_get_event_count(inputBuffer);
+    inputIndex = 0;
+    cycleFrames = nframes;
+    return inputCount;
+}
+
+jack_nframes_t Controller::nextInputTime() {
+    if (inputIndex >= inputCount) return cycleFrames;
+    jack_midi_event_t in_event;
+    if (jack_midi_event_get(&in_event, inputBuffer, inputIndex) != 0) return cycleFrames;
+    return in_event.time;
+}
+
+bool Controller::readInput(ControlEvent &e, MidiEvent &raw) {
+    if (inputIndex >= inputCount) return false;
+    jack_midi_event_t in_event;
+    int status = jack_midi_event_get(&in_event, inputBuffer, inputIndex++);
+    if (status != 0) return false;
+    flightRecorder().recordMidi(FlightRecorder::MIDI_IN, in_event.buffer, in_event.size, in_event.time);
+    raw = MidiEvent(in_event);
+    e.action = ControlEvent::NONE;
+    profile.decode(raw, e);
+    return true;
+}
+
+void Controller::queueOutput(const MidiEvent &e) {
+    if (!profile.hasLights) return;
+    outputEvents.push(e);
+}
+
+size_t Controller::queueLights() {
+    // the link is still busy with the last lot
+    if (lightHead < lightCount) return 0;
+    lightHead = 0;
+    lightCount = lights.getMidiEvents(lightEvents.data(), lightEvents.size());
+    if (!profile.hasLights) {
+        lightCount = 0;
+        return 0;
+    }
+    lightsQueuedAt = frameClock;
+    return lightCount;
+}
+
+bool Controller::writeEvent(void *port_buf, jack_nframes_t time, const unsigned char *data, size_t size) {
+    unsigned char encoded[3];
+    // the recorder shows the whole message, even if the status byte is left out
+    const unsigned char *message = data;
+    size_t messageSize = size;
+    // only short messages are worth encoding, sysex goes out as is
+    if (size <= sizeof(encoded)) {
+        size_t encodedSize = encoder.encode(data, size, encoded, frameClock + time);
+        metricBytesSaved->inc(size - encodedSize);
+        data = encoded;
+        size = encodedSize;
+    } else {
+        encoder.encode(data, 1, encoded, frameClock + time);
+    }
+    unsigned char* buffer = jack_midi_event_reserve(port_buf, time, size);
+    if (!buffer) {
+        metricOutputFull->inc();
+        // we don't know if the receiver saw the status byte now
+        encoder.requestResync();
+        return false;
+    }
+    memcpy(buffer, data, size);
+    flightRecorder().recordMidi(FlightRecorder::MIDI_OUT, message, messageSize, time);
+    shaper.send(time, size);
+    metricBytes->inc(size);
+    return true;
+}
+
+size_t Controller::writeOutput(jack_nframes_t nframes) {
+    void *port_buf = jack_port_get_buffer(outputPort, nframes);
+    jack_midi_clear_buffer(port_buf);
+    // sort the timed events (stable, there are only a few)
+    size_t count = 0;
+    while(count < cycleEvents.size() && outputEvents.pop(cycleEvents[count])) {
+        MidiEvent e = cycleEvents[count];
+        if (e.time >= nframes) e.time = nframes - 1;
+        size_t j = count;
+        while (j > 0 && cycleEvents[j - 1].time > e.time) {
+            cycleEvents[j] = cycleEvents[j - 1];
+            j--;
+        }
+        cycleEvents[j] = e;
+        count++;
+    }
+    // merge with the thru events, which are already in order, and fit the
+    // lights into the gaps the link has left
+    jack_nframes_t thruIndex = thru.enabled() ? 0 : inputCount;
+    unsigned int thruLeft = thruBudget;
+    jack_midi_event_t in_event;
+    bool haveThru = false;
+    size_t next = 0, written = 0;
+    jack_nframes_t lastTime = 0;
+    // set once jack's buffer has no room for the next light
+    bool lightsBlocked = false;
+    unsigned char bytes[3];
+    while (true) {
+        while (!haveThru && thruIndex < inputCount) {
+            if (jack_midi_event_get(&in_event, inputBuffer, thruIndex++) != 0) continue;
+            if (!thru.passes(in_event.buffer, in_event.size)) continue;
+            // anything ModMidi acts on itself stays here
+            ControlEvent c;
+            if (profile.decode(MidiEvent(in_event), c)) continue;
+            if (thruLeft == 0) {
+                metricThruBudget->inc();
+                continue;
+            }
+            thruLeft--;
+            haveThru = true;
+        }
+        bool haveTimed = next < count;
+        // the next event that has to go out at a particular time
+        jack_nframes_t deadline = nframes;
+        if (haveThru) deadline = in_event.time;
+        if (haveTimed && cycleEvents[next].time < deadline) deadline = cycleEvents[next].time;
+        if (lightHead < lightCount && !lightsBlocked) {
+            MidiEvent &e = lightEvents[lightHead];
+            size_t size = e.toBytes(bytes);
+            jack_nframes_t time = shaper.nextFree(lastTime);
+            // a light mustn't hold up a timed event, but the last one in a
+            // cycle can still be going out when the cycle ends
+            bool fits = (haveThru || haveTimed) ? shaper.fits(time, size, deadline) : time < nframes;
+            if (size == 0) {
+                lightHead++;
+                continue;
+            }
+            if (fits) {
+                // a light jack couldn't take is carried over to the next cycle
+                if (!writeEvent(port_buf, time, bytes, size)) {
+                    lightsBlocked = true;
+                    continue;
+                }
+                lightHead++;
+                written++;
+                lastTime = time;
+                metricLightDelay->observe((frameClock + time - lightsQueuedAt) * 1000000 / sampleRate);
+                continue;
+            }
+        }
+        if (!haveThru && !haveTimed) break;
+        if (haveThru && (!haveTimed || in_event.time <= cycleEvents[next].time)) {
+            // copy the bytes straight across
+            jack_nframes_t time = in_event.time > lastTime ? in_event.time : lastTime;
+            if (writeEvent(port_buf, time, in_event.buffer, in_event.size)) {
+                metricThru->inc();
+                lastTime = time;
+            }
+            haveThru = false;
+        } else {
+            MidiEvent &e = cycleEvents[next++];
+            size_t size = e.toBytes(bytes);
+            if (size == 0) continue;
+            jack_nframes_t time = e.time > lastTime ? e.time : lastTime;
+            if (writeEvent(port_buf, time, bytes, size)) {
+                written++;
+                lastTime = time;
+            }
+        }
+    }
+    if (lightHead < lightCount) metricCarried->inc(lightCount - lightHead);
+    metricBacklog->set(shaper.backlogBytes());
+    shaper.endCycle(nframes);
+    frameClock += nframes;
+    return written;
+}
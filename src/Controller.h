@@ -0,0 +1,108 @@
+/*
+ * File:   Controller.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <atomic>
+#include <string>
+#include <jack/jack.h>
+
+#include "MidiEvent.h"
+#include "FCBLights.h"
+#include "BoundedQueue.h"
+#include "DeviceProfile.h"
+#include "MidiThru.h"
+#include "OutputShaper.h"
+#include "RunningStatus.h"
+#include "Gesture.h"
+#include "Metrics.h"
+
+// One controller connected to ModMidi, with its own pair of jack ports, its
+// own lights and its own output queue. The worker owns one of these per
+// floorboard.
+class Controller {
+public:
+    Controller(std::string name, jack_port_t *inputPort, jack_port_t *outputPort, const DeviceProfile &profile);
+    virtual ~Controller();
+    std::string getName();
+    jack_port_t *getInputPort();
+    jack_port_t *getOutputPort();
+    const DeviceProfile &getProfile();
+    bool hasLights();
+    FCBLights &getLights();
+    // only used from the jack realtime thread, once running
+    GestureEngine &getGestures();
+    // pass matching input straight to the output, at most budget events per
+    // cycle, call before the worker is handed to jack
+    void setThru(const ThruFilter &filter, unsigned int budget);
+    // bytes a second the link to the controller can carry, 0 for no limit
+    void setLinkRate(unsigned int bytesPerSecond, jack_nframes_t sampleRate);
+    // use running status on the output, sending the full status again at
+    // least every resyncMsec (0 for never)
+    void setRunningStatus(bool enabled, int resyncMsec, jack_nframes_t sampleRate);
+    // the controller may have lost track of the running status, thread safe
+    void resync();
+    // from jack's latency callback: passes the latency through from one port
+    // to the other, like thru does, and remembers it
+    void updateLatency(jack_latency_callback_mode_t mode);
+    // frames from a press leaving the controller until the reply lights it,
+    // as far as jack knows, thread safe
+    jack_nframes_t getRoundTripLatency();
+
+    // the following are called from the jack realtime thread
+
+    // get the input buffer for this cycle, returns the number of events
+    jack_nframes_t beginCycle(jack_nframes_t nframes);
+    // frame of the next unread input event, or nframes if there are none left
+    jack_nframes_t nextInputTime();
+    // reads the next input event, the action is NONE if it isn't bound to
+    // anything, returns false if there was nothing to read
+    bool readInput(ControlEvent &e, MidiEvent &raw);
+    // queue a timed event for the controller (e.g. the tempo light), these go
+    // out at their time ahead of the lights, ignored if it has no lights
+    void queueOutput(const MidiEvent &e);
+    // pick up whatever changed in the lights, returns the number of messages,
+    // nothing is picked up until the last lot has been sent so later changes
+    // to a light replace earlier ones
+    size_t queueLights();
+    // write this cycle's output: timed events and thru events at their time,
+    // and as many lights as the link has room for in between, the rest are
+    // carried over to the next cycle, returns the number of events written
+    size_t writeOutput(jack_nframes_t nframes);
+private:
+    std::string name;
+    jack_port_t *inputPort, *outputPort;
+    DeviceProfile profile;
+    FCBLights lights;
+    GestureEngine gestures;
+    BoundedQueue<MidiEvent> outputEvents;
+    // queued output is sorted here each cycle, allocated up front
+    std::vector<MidiEvent> cycleEvents;
+    // lights waiting for room on the link
+    std::vector<MidiEvent> lightEvents;
+    size_t lightCount = 0, lightHead = 0;
+    uint64_t lightsQueuedAt = 0;
+    OutputShaper shaper;
+    RunningStatusEncoder encoder;
+    jack_nframes_t sampleRate = 48000;
+    // frames since the controller was created
+    uint64_t frameClock = 0;
+    bool writeEvent(void *port_buf, jack_nframes_t time, const unsigned char *data, size_t size);
+    ThruFilter thru;
+    unsigned int thruBudget = 0;
+    Counter *metricThru, *metricThruBudget, *metricOutputFull, *metricCarried;
+    Counter *metricBytes, *metricBytesSaved;
+    Histogram *metricLightDelay;
+    Gauge *metricBacklog;
+    void *inputBuffer = NULL;
+    jack_nframes_t inputCount = 0, inputIndex = 0, cycleFrames = 0;
+    std::atomic<jack_nframes_t> captureLatency{0}, playbackLatency{0};
+};
+
+#endif /* CONTROLLER_H */
+
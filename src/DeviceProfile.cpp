@@ -0,0 +1,104 @@
+/*
+ * File:   DeviceProfile.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "DeviceProfile.h"
+
+static void bind(DeviceProfile &p, MidiEvent::EventType type, unsigned char data1, int data2, ControlEvent::Action action, unsigned int index = 0, bool release = false) {
+    DeviceProfile::Binding b;
+    b.eventType = type;
+    b.data1 = data1;
+    b.data2 = data2;
+    b.action = action;
+    b.index = index;
+    b.release = release;
+    p.bindings.push_back(b);
+}
+
+static void bindGesture(DeviceProfile &p, ControlEvent::Action action, unsigned int index, ControlEvent::Gesture gesture, ControlEvent::Action mapped, unsigned int mappedIndex = 0) {
+    DeviceProfile::GestureBinding b;
+    b.action = action;
+    b.index = index;
+    b.gesture = gesture;
+    b.mapped = mapped;
+    b.mappedIndex = mappedIndex;
+    p.gestures.push_back(b);
+}
+
+// Up pages up, a double tap skips to the next bank and holding it pages back
+// down, the others act as soon as they're pressed
+static void bindUpGestures(DeviceProfile &p) {
+    bindGesture(p, ControlEvent::BANK_UP, 0, ControlEvent::DOUBLE_TAP, ControlEvent::SKIP_BANK);
+    bindGesture(p, ControlEvent::BANK_UP, 0, ControlEvent::LONG_PRESS, ControlEvent::BANK_DOWN);
+    bindGesture(p, ControlEvent::BANK_UP, 0, ControlEvent::HOLD_REPEAT, ControlEvent::BANK_DOWN);
+}
+
+// Behringer FCB1010 running the ModMidi EEPROM, every switch sends CC104 with
+// its own value when pressed (and CC105 with the same value when let go, if
+// the EEPROM is new enough) and the lights are driven with CC106/107/108
+static DeviceProfile fcb1010() {
+    DeviceProfile p;
+    p.name = "fcb1010";
+    p.hasLights = true;
+    for (int cc=104; cc<=105; cc++) {
+        bool release = cc == 105;
+        for (int i=0; i<5; i++) {
+            bind(p, MidiEvent::CC, cc, i + 1, ControlEvent::PRESET, i, release);
+        }
+        for (int i=0; i<4; i++) {
+            bind(p, MidiEvent::CC, cc, i + 6, ControlEvent::PEDALBOARD, i, release);
+        }
+        bind(p, MidiEvent::CC, cc, 0, ControlEvent::PEDALBOARD, 4, release);
+        bind(p, MidiEvent::CC, cc, 10, ControlEvent::BANK_UP, 0, release);
+        bind(p, MidiEvent::CC, cc, 11, ControlEvent::TAP_TEMPO, 0, release);
+    }
+    bindUpGestures(p);
+    return p;
+}
+
+// any controller with momentary switches sending CC20-31, no lights
+static DeviceProfile generic() {
+    DeviceProfile p;
+    p.name = "generic";
+    p.hasLights = false;
+    for (int i=0; i<5; i++) {
+        bind(p, MidiEvent::CC, 20 + i, -1, ControlEvent::PRESET, i);
+        bind(p, MidiEvent::CC, 25 + i, -1, ControlEvent::PEDALBOARD, i);
+    }
+    bind(p, MidiEvent::CC, 30, -1, ControlEvent::BANK_UP);
+    bind(p, MidiEvent::CC, 31, -1, ControlEvent::TAP_TEMPO);
+    bindUpGestures(p);
+    return p;
+}
+
+bool DeviceProfile::decode(const MidiEvent &e, ControlEvent &out) const {
+    for (const Binding &b : bindings) {
+        if (b.eventType != e.eventType || b.data1 != e.data1) continue;
+        if (b.data2 >= 0 && b.data2 != e.data2) continue;
+        out.action = b.action;
+        out.index = b.index;
+        out.time = e.time;
+        out.gesture = ControlEvent::TAP;
+        out.release = b.release || (b.data2 < 0 && e.data2 == 0);
+        return true;
+    }
+    return false;
+}
+
+bool DeviceProfile::find(std::string name, DeviceProfile &profile) {
+    if (name == "fcb1010") {
+        profile = fcb1010();
+    } else if (name == "generic") {
+        profile = generic();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> DeviceProfile::names() {
+    return {"fcb1010", "generic"};
+}
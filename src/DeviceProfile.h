@@ -0,0 +1,90 @@
+/*
+ * File:   DeviceProfile.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef DEVICEPROFILE_H
+#define DEVICEPROFILE_H
+
+#include <string>
+#include <vector>
+#include <jack/jack.h>
+
+#include "MidiEvent.h"
+
+// a switch press, decoded from whatever the controller sent
+class ControlEvent {
+public:
+    enum Gesture {
+        // a press that wasn't any of the others
+        TAP,
+        DOUBLE_TAP,
+        LONG_PRESS,
+        HOLD_REPEAT
+    };
+    enum Action {
+        NONE,
+        PRESET,
+        PEDALBOARD,
+        BANK_UP,
+        TAP_TEMPO,
+        // the previous 5 pedalboards
+        BANK_DOWN,
+        // the first page of the Mod's next bank
+        SKIP_BANK
+    };
+    Action action = NONE;
+    // which preset or pedalboard switch, 0-4
+    unsigned int index = 0;
+    // frame offset within the jack cycle it arrived in
+    jack_nframes_t time = 0;
+    // index of the controller it came from
+    int controller = -1;
+    Gesture gesture = TAP;
+    // the switch was let go, only seen by the gesture engine
+    bool release = false;
+};
+
+// describes how a kind of controller maps its switches, and whether it has
+// FCB1010 style lights & digits
+class DeviceProfile {
+public:
+    class Binding {
+    public:
+        MidiEvent::EventType eventType;
+        unsigned char data1;
+        // -1 matches any non zero value, and zero is the switch's release
+        int data2;
+        ControlEvent::Action action;
+        unsigned int index;
+        // this binding is the switch being let go
+        bool release;
+    };
+    // a gesture on one of the switches that does something other than the
+    // switch's own action, switches without any act on every press
+    class GestureBinding {
+    public:
+        ControlEvent::Action action;
+        unsigned int index;
+        ControlEvent::Gesture gesture;
+        ControlEvent::Action mapped;
+        unsigned int mappedIndex;
+    };
+    std::string name;
+    bool hasLights = false;
+    std::vector<Binding> bindings;
+    std::vector<GestureBinding> gestures;
+
+    // safe to call from the jack realtime thread, returns false if the event
+    // isn't bound to anything
+    bool decode(const MidiEvent &e, ControlEvent &out) const;
+
+    // looks up one of the built in profiles
+    static bool find(std::string name, DeviceProfile &profile);
+    static std::vector<std::string> names();
+};
+
+#endif /* DEVICEPROFILE_H */
+
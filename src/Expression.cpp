@@ -0,0 +1,99 @@
+/*
+ * File:   Expression.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "Expression.h"
+
+#include <cmath>
+#include <cstdlib>
+
+bool ExpressionMapping::parse(std::string spec) {
+    size_t equals = spec.find('=');
+    if (equals == std::string::npos || equals == 0) return false;
+    int number = atoi(spec.substr(0, equals).c_str());
+    if (number < 0 || number > 127) return false;
+    cc = number;
+    std::string rest = spec.substr(equals + 1);
+    size_t colon = rest.find(':');
+    port = rest.substr(0, colon);
+    if (port.size() == 0) return false;
+    if (colon == std::string::npos) return true;
+    size_t colon2 = rest.find(':', colon + 1);
+    if (colon2 == std::string::npos) return false;
+    minimum = atof(rest.substr(colon + 1, colon2 - colon - 1).c_str());
+    maximum = atof(rest.substr(colon2 + 1).c_str());
+    return true;
+}
+
+ExpressionMap::ExpressionMap() {
+    metricUpdates = metrics().counter("modmidi_parameter_updates_total", "Smoothed expression pedal values published for sending");
+}
+
+bool ExpressionMap::add(const ExpressionMapping &mapping) {
+    if (count >= MAX_MAPPINGS) return false;
+    mappings[count++] = mapping;
+    return true;
+}
+
+void ExpressionMap::setSmoothing(int msec) {
+    smoothingMsec = msec;
+}
+
+void ExpressionMap::setDeadband(double deadband) {
+    this->deadband = deadband;
+}
+
+int ExpressionMap::size() {
+    return count;
+}
+
+const ExpressionMapping &ExpressionMap::getMapping(int i) {
+    return mappings[i];
+}
+
+bool ExpressionMap::input(const MidiEvent &e) {
+    if (e.eventType != MidiEvent::CC) return false;
+    bool mapped = false;
+    for (int i=0; i<count; i++) {
+        if (mappings[i].cc != e.data1) continue;
+        Slot &slot = slots[i];
+        slot.target = e.data2 / 127.0f;
+        slot.targetChanged = std::chrono::steady_clock::now().time_since_epoch().count();
+        // no point gliding up from nothing on the first move
+        if (slot.smoothed < 0) slot.smoothed = slot.target;
+        mapped = true;
+    }
+    return mapped;
+}
+
+void ExpressionMap::process(jack_nframes_t nframes, jack_nframes_t sampleRate) {
+    // one pole low pass, with the time constant in smoothingMsec
+    float alpha = 1;
+    if (smoothingMsec > 0) alpha = 1 - std::exp(-(float)nframes * 1000.0f / ((float)sampleRate * smoothingMsec));
+    for (int i=0; i<count; i++) {
+        Slot &slot = slots[i];
+        if (slot.target < 0) continue;
+        slot.smoothed += alpha * (slot.target - slot.smoothed);
+        if (std::fabs(slot.target - slot.smoothed) < 0.0005f) slot.smoothed = slot.target;
+        // always send the value the pedal came to rest at, even inside the deadband
+        bool settled = slot.smoothed == slot.target && slot.published != slot.target;
+        if (!settled && std::fabs(slot.smoothed - slot.published) < deadband) continue;
+        slot.published = slot.smoothed;
+        const ExpressionMapping &m = mappings[i];
+        slot.value.store(m.minimum + (m.maximum - m.minimum) * slot.smoothed, std::memory_order_relaxed);
+        slot.changed.store(slot.targetChanged, std::memory_order_relaxed);
+        slot.sequence.fetch_add(1, std::memory_order_release);
+        metricUpdates->inc();
+    }
+}
+
+uint32_t ExpressionMap::latest(int i, double &value, std::chrono::steady_clock::time_point &changed) {
+    Slot &slot = slots[i];
+    uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+    value = slot.value.load(std::memory_order_relaxed);
+    changed = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(slot.changed.load(std::memory_order_relaxed)));
+    return sequence;
+}
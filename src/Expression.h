@@ -0,0 +1,77 @@
+/*
+ * File:   Expression.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <jack/jack.h>
+
+#include "MidiEvent.h"
+#include "Metrics.h"
+
+class ExpressionMapping {
+public:
+    unsigned char cc = 0;
+    // Mod parameter port, e.g. /graph/ds1/level
+    std::string port;
+    double minimum = 0, maximum = 1;
+    // parses CC=PORT[:MIN:MAX]
+    bool parse(std::string spec);
+};
+
+// Expression pedal CCs mapped to plugin parameters. The jack thread feeds the
+// raw CCs in and smooths them once per cycle, and only changes bigger than the
+// deadband are published. Senders just read the latest value of each
+// parameter, so however fast the pedal moves only the newest value is sent.
+// this class is thread safe
+class ExpressionMap {
+public:
+    static const int MAX_MAPPINGS = 8;
+    ExpressionMap();
+    // these should be called before the worker is handed to jack
+    bool add(const ExpressionMapping &mapping);
+    void setSmoothing(int msec);
+    // fraction of the pedal's range
+    void setDeadband(double deadband);
+    int size();
+    const ExpressionMapping &getMapping(int i);
+
+    // the following are called from the jack realtime thread
+
+    // returns false if the CC isn't mapped
+    bool input(const MidiEvent &e);
+    void process(jack_nframes_t nframes, jack_nframes_t sampleRate);
+
+    // get the newest parameter value (already scaled to min-max) and when the
+    // pedal movement behind it arrived, the returned sequence number changes
+    // whenever there's a new value
+    uint32_t latest(int i, double &value, std::chrono::steady_clock::time_point &changed);
+private:
+    class Slot {
+    public:
+        // only used on the jack thread, -1 until the pedal is first moved
+        float target = -1, smoothed = -1, published = -1;
+        int64_t targetChanged = 0;
+        // handed to the senders
+        std::atomic<float> value{0};
+        std::atomic<int64_t> changed{0};
+        std::atomic<uint32_t> sequence{0};
+    };
+    ExpressionMapping mappings[MAX_MAPPINGS];
+    Slot slots[MAX_MAPPINGS];
+    int count = 0;
+    int smoothingMsec = 30;
+    float deadband = 0.005;
+    Counter *metricUpdates;
+};
+
+#endif /* EXPRESSION_H */
+
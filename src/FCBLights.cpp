@@ -45,6 +45,7 @@ FCBLights::FCBLights() {
     // set up the lights
     for (int i=0; i<10; i++) {
         pedals.push_back(Light<bool>(false));
+        pending.push_back(false);
     }
     for (int i=0; i<13; i++) {
         miscLights.push_back(Light<bool>(false));
@@ -58,6 +59,24 @@ void FCBLights::setPedal(unsigned int pedalNum, bool state) {
     if (pedalNum >= pedals.size()) return;
     std::lock_guard<std::mutex> guard(m_access);
     pedals.at(pedalNum).setValue(state);
+    // the answer always goes out, even if the last blink left the light the
+    // same, so anything watching knows the pedal has stopped blinking
+    if (pending.at(pedalNum)) pedals.at(pedalNum).setDirty(true);
+    pending.at(pedalNum) = false;
+}
+
+void FCBLights::setPending(unsigned int pedalNum) {
+    if (pedalNum >= pedals.size()) return;
+    std::lock_guard<std::mutex> guard(m_access);
+    pedals.at(pedalNum).setValue(true);
+    pending.at(pedalNum) = true;
+}
+
+void FCBLights::setBlinkState(bool on) {
+    std::lock_guard<std::mutex> guard(m_access);
+    for (size_t i=0; i<pedals.size(); i++) {
+        if (pending.at(i)) pedals.at(i).setValue(on);
+    }
 }
 
 void FCBLights::setMiscLight(unsigned int lightNum, bool state) {
@@ -82,42 +101,40 @@ void FCBLights::markAllDirty() {
     digits.setDirty(true);
 }
 
-std::vector<MidiEvent> FCBLights::getMidiEvents() {
+size_t FCBLights::getMidiEvents(MidiEvent *events, size_t max) {
     std::lock_guard<std::mutex> guard(m_access);
-    std::vector<MidiEvent> events;
-    for (size_t i=0; i<pedals.size(); i++) {
+    size_t count = 0;
+    for (size_t i=0; i<pedals.size() && count < max; i++) {
         auto &pedal = pedals.at(i);
         if (pedal.isDirty()) {
             pedal.setDirty(false);
-            MidiEvent e;
+            MidiEvent &e = events[count++];
             e.eventType = MidiEvent::CC;
             e.data1 = pedal.getValue() ? 106 : 107;
             e.data2 = (i == 9) ? 0 : i + 1;
-            events.push_back(e);
         }
     }
     for (size_t i=0; i<miscLights.size(); i++) {
         auto &light = miscLights.at(i);
         if (light.isDirty()) {
-            light.setDirty(false);
             // skip 0, 1, and 2 because they get overridden by the FCB itself
-            if (i <= 2) continue;
             // skip 5 because we're using it for tap tempo
-            if (i == 5) continue;
-            MidiEvent e;
+            bool skip = i <= 2 || i == 5;
+            if (!skip && count == max) break;
+            light.setDirty(false);
+            if (skip) continue;
+            MidiEvent &e = events[count++];
             e.eventType = MidiEvent::CC;
             e.data1 = light.getValue() ? 106 : 107;
             e.data2 = i + 11;
-            events.push_back(e);
         }
     }
-    if (digits.isDirty()) {
+    if (digits.isDirty() && count < max) {
         digits.setDirty(false);
-        MidiEvent e;
+        MidiEvent &e = events[count++];
         e.eventType = MidiEvent::CC;
         e.data1 = 108;
         e.data2 = digits.getValue();
-        events.push_back(e);
     }
-    return events;
+    return count;
 }
\ No newline at end of file
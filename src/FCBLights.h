@@ -39,11 +39,19 @@ public:
     
     void markAllDirty();
     
-    std::vector<MidiEvent> getMidiEvents();
+    // pending pedals blink until the next setPedal() call for them, used to
+    // show a switch press right away while the Mod is still loading
+    void setPending(unsigned int pedalNum);
+    void setBlinkState(bool on);
+    
+    // fills in up to max messages for the lights that changed, anything that
+    // doesn't fit stays dirty for next time, doesn't allocate
+    size_t getMidiEvents(MidiEvent *events, size_t max);
 private:
     std::mutex m_access;
     std::vector<Light<bool>> pedals;
     std::vector<Light<bool>> miscLights;
+    std::vector<bool> pending;
     Light<unsigned int> digits{0};
 };
 
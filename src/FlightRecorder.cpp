@@ -0,0 +1,200 @@
+/*
+ * File:   FlightRecorder.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "FlightRecorder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <time.h>
+
+#include "Log.h"
+
+static uint64_t nowNsec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+FlightRecorder::FlightRecorder() {
+    slots = new Slot[SLOTS];
+    // touch every page now rather than on the realtime thread later
+    for (size_t i=0; i<SLOTS; i++) {
+        memset(slots[i].label, 0, LABEL_SIZE);
+    }
+    startTime = nowNsec();
+    sem_init(&dumpRequested, 0, 0);
+}
+
+FlightRecorder::~FlightRecorder() {
+    stopDumper();
+    sem_destroy(&dumpRequested);
+    delete[] slots;
+}
+
+int FlightRecorder::threadIndex() {
+    thread_local int index = -1;
+    if (index < 0) {
+        index = threadCount.fetch_add(1, std::memory_order_relaxed);
+        // threads past the limit share the last row
+        if (index >= MAX_THREADS) index = MAX_THREADS - 1;
+    }
+    return index;
+}
+
+void FlightRecorder::record(Type type, const char *label, uint32_t a, uint32_t b) {
+    uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = slots[index % SLOTS];
+    // readers skip the slot until it's finished
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.time = nowNsec();
+    slot.a = a;
+    slot.b = b;
+    slot.type = type;
+    slot.thread = threadIndex();
+    strncpy(slot.label, label, LABEL_SIZE - 1);
+    slot.label[LABEL_SIZE - 1] = '\0';
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+void FlightRecorder::recordMidi(Type type, const unsigned char *data, size_t size, uint32_t frame) {
+    uint32_t packed = (uint32_t)(size > 3 ? 3 : size) << 24;
+    for (size_t i=0; i<size && i<3; i++) {
+        packed |= (uint32_t)data[i] << (16 - 8 * i);
+    }
+    record(type, "", packed, frame);
+}
+
+void FlightRecorder::nameThread(const char *name) {
+    int index = threadIndex();
+    strncpy(threadNames[index], name, sizeof(threadNames[index]) - 1);
+}
+
+static void appendEscaped(std::string &out, const char *text) {
+    for (const char *c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') out += '\\';
+        if ((unsigned char)*c < 0x20) continue;
+        out += *c;
+    }
+}
+
+std::string FlightRecorder::dump() {
+    static const char *typeNames[] = {"midi in", "midi out", "", "", "", "tap", "xrun"};
+    uint64_t end = writeIndex.load(std::memory_order_acquire);
+    uint64_t begin = end > SLOTS ? end - SLOTS : 0;
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    int threads = threadCount.load(std::memory_order_relaxed);
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    for (int i=0; i<threads; i++) {
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(i) + ",\"args\":{\"name\":\"";
+        appendEscaped(out, threadNames[i][0] ? threadNames[i] : "unnamed");
+        out += "\"}},\n";
+    }
+    char buffer[256];
+    for (uint64_t index = begin; index < end; index++) {
+        Slot &slot = slots[index % SLOTS];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1) continue;
+        Slot copy;
+        copy.time = slot.time;
+        copy.a = slot.a;
+        copy.b = slot.b;
+        copy.type = slot.type;
+        copy.thread = slot.thread;
+        memcpy(copy.label, slot.label, LABEL_SIZE);
+        copy.label[LABEL_SIZE - 1] = '\0';
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // overwritten while we were copying it
+        if (slot.sequence.load(std::memory_order_relaxed) != index + 1) continue;
+        double ts = (double)(copy.time - startTime) / 1000.0;
+        std::string name = copy.label[0] ? copy.label : typeNames[copy.type];
+        std::string escaped;
+        appendEscaped(escaped, name.c_str());
+        const char *phase = "i";
+        if (copy.type == BEGIN) phase = "B";
+        if (copy.type == END) phase = "E";
+        snprintf(buffer, sizeof(buffer), "{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u", escaped.c_str(), phase, ts, (unsigned int)copy.thread);
+        out += buffer;
+        switch(copy.type) {
+            case MIDI_IN:
+            case MIDI_OUT: {
+                std::string bytes;
+                unsigned int size = copy.a >> 24;
+                for (unsigned int i=0; i<size; i++) {
+                    snprintf(buffer, sizeof(buffer), "%s%02x", i ? " " : "", (copy.a >> (16 - 8 * i)) & 0xff);
+                    bytes += buffer;
+                }
+                snprintf(buffer, sizeof(buffer), ",\"s\":\"t\",\"args\":{\"bytes\":\"%s\",\"frame\":%u}", bytes.c_str(), copy.b);
+                break;
+            }
+            case BEGIN:
+                snprintf(buffer, sizeof(buffer), ",\"args\":{\"bytes\":%u}", copy.a);
+                break;
+            case END:
+                snprintf(buffer, sizeof(buffer), ",\"args\":{\"bytes\":%u,\"ok\":%s}", copy.a, copy.b ? "true" : "false");
+                break;
+            case STATE:
+                snprintf(buffer, sizeof(buffer), ",\"s\":\"t\",\"args\":{\"value\":%d,\"detail\":%d}", (int32_t)copy.a, (int32_t)copy.b);
+                break;
+            case TAP:
+                snprintf(buffer, sizeof(buffer), ",\"s\":\"t\",\"args\":{\"bpm\":%.2f,\"frame\":%u}", copy.a / 100.0, copy.b);
+                break;
+            default:
+                snprintf(buffer, sizeof(buffer), ",\"s\":\"g\"");
+                break;
+        }
+        out += buffer;
+        out += "},\n";
+    }
+    // drop the trailing comma
+    if (out.compare(out.size() - 2, 2, ",\n") == 0) out.erase(out.size() - 2);
+    out += "\n]}\n";
+    return out;
+}
+
+void FlightRecorder::startDumper(std::string filename) {
+    this->filename = filename;
+    dumper_quit = false;
+    dumper_thread = std::thread([this] {
+        nameThread("dumper");
+        while (true) {
+            // sem_wait can be interrupted by the signal that posts it
+            if (sem_wait(&dumpRequested) != 0) continue;
+            if (dumper_quit) break;
+            std::string trace = dump();
+            // write it somewhere else first so a reader never sees half a file
+            std::string temp = this->filename + ".tmp";
+            FILE *f = fopen(temp.c_str(), "w");
+            if (!f) {
+                LOG_ERROR("Unable to write flight recorder to %s", temp.c_str());
+                continue;
+            }
+            bool written = fwrite(trace.c_str(), 1, trace.size(), f) == trace.size();
+            if (fclose(f) != 0) written = false;
+            if (!written || rename(temp.c_str(), this->filename.c_str()) != 0) {
+                LOG_ERROR("Unable to write flight recorder to %s", this->filename.c_str());
+                continue;
+            }
+            LOG_INFO("Flight recorder written to %s", this->filename.c_str());
+        }
+    });
+}
+
+void FlightRecorder::stopDumper() {
+    if (!dumper_thread.joinable()) return;
+    dumper_quit = true;
+    sem_post(&dumpRequested);
+    dumper_thread.join();
+}
+
+void FlightRecorder::requestDump() {
+    sem_post(&dumpRequested);
+}
+
+FlightRecorder &flightRecorder() {
+    static FlightRecorder recorder;
+    return recorder;
+}
@@ -0,0 +1,81 @@
+/*
+ * File:   FlightRecorder.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <semaphore.h>
+#include <stdint.h>
+
+// An always-on record of the last few thousand things that happened: MIDI in
+// & out, commands sent to the Mod and their responses, status updates, taps
+// and xruns. Recording is a clock read, an atomic increment and a small copy,
+// with no locks or allocation, so it's safe from the jack realtime thread.
+// Old events are overwritten. dump() turns the ring into a Chrome trace (open
+// it in chrome://tracing or ui.perfetto.dev).
+// this class is thread safe
+class FlightRecorder {
+public:
+    enum Type {
+        MIDI_IN,
+        MIDI_OUT,
+        // a span on one thread, e.g. a command & its response
+        BEGIN,
+        END,
+        STATE,
+        TAP,
+        XRUN
+    };
+    static const size_t SLOTS = 16384;
+    static const size_t LABEL_SIZE = 22;
+    static const int MAX_THREADS = 32;
+
+    FlightRecorder();
+    virtual ~FlightRecorder();
+    // label is copied (and cut short if needed), a & b depend on the type
+    void record(Type type, const char *label, uint32_t a = 0, uint32_t b = 0);
+    // MIDI bytes are packed into a, with the frame offset in b
+    void recordMidi(Type type, const unsigned char *data, size_t size, uint32_t frame);
+    // name the calling thread in the trace
+    void nameThread(const char *name);
+    std::string dump();
+
+    // dumps go to this file, from their own thread
+    void startDumper(std::string filename);
+    void stopDumper();
+    // safe to call from a signal handler
+    void requestDump();
+private:
+    class Slot {
+    public:
+        // index + 1 once the slot is written
+        std::atomic<uint64_t> sequence{0};
+        uint64_t time;
+        uint32_t a, b;
+        uint8_t type, thread;
+        char label[LABEL_SIZE];
+    };
+    Slot *slots;
+    std::atomic<uint64_t> writeIndex{0};
+    uint64_t startTime;
+    char threadNames[MAX_THREADS][16] = {};
+    std::atomic<int> threadCount{0};
+    int threadIndex();
+
+    sem_t dumpRequested;
+    std::thread dumper_thread;
+    std::atomic<bool> dumper_quit{false};
+    std::string filename;
+};
+
+FlightRecorder &flightRecorder();
+
+#endif /* FLIGHTRECORDER_H */
+
@@ -0,0 +1,169 @@
+/*
+ * File:   Gesture.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "Gesture.h"
+
+#include <stdlib.h>
+
+bool GestureTimes::parse(std::string spec) {
+    size_t colon = spec.find(':');
+    if (colon == std::string::npos || colon == 0) return false;
+    doubleTapMsec = atoi(spec.substr(0, colon).c_str());
+    std::string rest = spec.substr(colon + 1);
+    size_t colon2 = rest.find(':');
+    longPressMsec = atoi(rest.substr(0, colon2).c_str());
+    if (colon2 != std::string::npos) repeatMsec = atoi(rest.substr(colon2 + 1).c_str());
+    return doubleTapMsec >= 0 && longPressMsec >= 0 && repeatMsec >= 0;
+}
+
+GestureEngine::GestureEngine() {
+    setTimes(GestureTimes(), 48000);
+}
+
+void GestureEngine::setTimes(const GestureTimes &times, jack_nframes_t sampleRate) {
+    doubleTapFrames = (uint64_t)times.doubleTapMsec * sampleRate / 1000;
+    longPressFrames = (uint64_t)times.longPressMsec * sampleRate / 1000;
+    repeatFrames = (uint64_t)times.repeatMsec * sampleRate / 1000;
+}
+
+void GestureEngine::setProfile(const DeviceProfile &profile) {
+    for (int i=0; i<MAX_SWITCHES; i++) {
+        switches[i] = Switch();
+    }
+    for (auto &b : profile.gestures) {
+        int slot = (int)b.action * 5 + (int)b.index;
+        if (slot < 0 || slot >= MAX_SWITCHES || b.gesture == ControlEvent::TAP) continue;
+        Switch &s = switches[slot];
+        s.bound[b.gesture] = true;
+        s.action[b.gesture] = b.mapped;
+        s.index[b.gesture] = b.mappedIndex;
+    }
+}
+
+bool GestureEngine::wantsDoubleTap(const Switch &s) {
+    return s.bound[ControlEvent::DOUBLE_TAP] && doubleTapFrames > 0;
+}
+
+bool GestureEngine::wantsHold(const Switch &s) {
+    if (!sendsReleases || longPressFrames == 0) return false;
+    return s.bound[ControlEvent::LONG_PRESS] || (s.bound[ControlEvent::HOLD_REPEAT] && repeatFrames > 0);
+}
+
+ControlEvent GestureEngine::gesture(const Switch &s, ControlEvent::Gesture g, jack_nframes_t time) {
+    ControlEvent out = s.press;
+    out.gesture = g;
+    out.time = time;
+    if (g != ControlEvent::TAP) {
+        out.action = s.action[g];
+        out.index = s.index[g];
+    }
+    return out;
+}
+
+// the next long press or repeat of a held switch
+ControlEvent GestureEngine::holdGesture(Switch &s, jack_nframes_t time) {
+    bool first = !s.holdSent;
+    s.holdSent = true;
+    s.tapPending = false;
+    if (s.bound[ControlEvent::HOLD_REPEAT] && repeatFrames > 0) {
+        s.nextHold += repeatFrames;
+    } else {
+        s.held = false;
+    }
+    bool longPress = first && s.bound[ControlEvent::LONG_PRESS];
+    return gesture(s, longPress ? ControlEvent::LONG_PRESS : ControlEvent::HOLD_REPEAT, time);
+}
+
+int GestureEngine::input(const ControlEvent &e, uint64_t frame, ControlEvent *out) {
+    int slot = (int)e.action * 5 + (int)e.index;
+    if (slot < 0 || slot >= MAX_SWITCHES) {
+        // nothing to keep track of, pass it on as it is
+        if (e.release) return 0;
+        out[0] = e;
+        return 1;
+    }
+    Switch &s = switches[slot];
+    // frames from this event back to an earlier frame in the same cycle
+    auto at = [&] (uint64_t earlier) -> jack_nframes_t {
+        uint64_t back = frame - earlier;
+        return e.time > back ? e.time - (jack_nframes_t)back : 0;
+    };
+    if (e.release) {
+        sendsReleases = true;
+        if (!s.held) return 0;
+        // a hold that came due earlier in this cycle, before poll() saw it
+        if (frame >= s.nextHold) {
+            out[0] = holdGesture(s, at(s.nextHold));
+            s.held = false;
+            return 1;
+        }
+        s.held = false;
+        // let go before it was a long press, so it's a tap once it can't be
+        // a double tap either
+        if (s.tapPending && frame >= s.tapDue) {
+            s.tapPending = false;
+            out[0] = gesture(s, ControlEvent::TAP, e.time);
+            return 1;
+        }
+        return 0;
+    }
+    int count = 0;
+    // pressing another switch settles a tap that's waiting, so it can't be
+    // overtaken. only one can be waiting since every press gets here first
+    for (int i=0; i<MAX_SWITCHES; i++) {
+        Switch &other = switches[i];
+        if (i == slot || !other.tapPending) continue;
+        other.tapPending = false;
+        other.held = false;
+        out[count++] = gesture(other, ControlEvent::TAP, e.time);
+        break;
+    }
+    bool doubleTap = wantsDoubleTap(s);
+    bool hold = wantsHold(s);
+    if (!doubleTap && !hold) {
+        out[count] = e;
+        out[count++].gesture = ControlEvent::TAP;
+        return count;
+    }
+    // a tap that came due earlier in this cycle, before poll() saw it
+    if (s.tapPending && !s.held && frame >= s.tapDue) {
+        s.tapPending = false;
+        out[count++] = gesture(s, ControlEvent::TAP, at(s.tapDue));
+    }
+    if (s.tapPending && doubleTap && frame - s.pressFrame <= doubleTapFrames) {
+        // the second press takes the place of the first one's tap
+        s.tapPending = false;
+        s.held = false;
+        out[count++] = gesture(s, ControlEvent::DOUBLE_TAP, e.time);
+        return count;
+    }
+    s.press = e;
+    s.pressFrame = frame;
+    s.tapPending = true;
+    s.tapDue = frame + (doubleTap ? doubleTapFrames : 0);
+    s.held = hold;
+    s.holdSent = false;
+    s.nextHold = frame + longPressFrames;
+    return count;
+}
+
+bool GestureEngine::poll(uint64_t cycleStart, uint64_t cycleEnd, ControlEvent &out) {
+    for (int i=0; i<MAX_SWITCHES; i++) {
+        Switch &s = switches[i];
+        if (s.held && s.nextHold < cycleEnd) {
+            out = holdGesture(s, s.nextHold > cycleStart ? s.nextHold - cycleStart : 0);
+            return true;
+        }
+        // not held (or never going to be), and too late for a double tap
+        if (s.tapPending && !s.held && s.tapDue < cycleEnd) {
+            s.tapPending = false;
+            out = gesture(s, ControlEvent::TAP, s.tapDue > cycleStart ? s.tapDue - cycleStart : 0);
+            return true;
+        }
+    }
+    return false;
+}
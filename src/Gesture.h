@@ -0,0 +1,79 @@
+/*
+ * File:   Gesture.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include <string>
+#include <stdint.h>
+#include <jack/jack.h>
+
+#include "DeviceProfile.h"
+
+// how long the gestures take, in msec
+class GestureTimes {
+public:
+    // parses DOUBLE:LONG[:REPEAT], 0 turns that gesture off
+    bool parse(std::string spec);
+    // a second press within this long is a double tap
+    int doubleTapMsec = 300;
+    // held this long is a long press
+    int longPressMsec = 600;
+    // then a repeat this often until it's let go
+    int repeatMsec = 250;
+};
+
+// Turns one controller's switch presses & releases into gestures, timed with
+// the absolute frame each event happened at, and then into the actions the
+// profile binds them to. A switch without gesture bindings goes out straight
+// away as a TAP. A switch with some holds its TAP back until it can't be
+// anything else: a second press soon after is a DOUBLE_TAP instead, and
+// holding it down is a LONG_PRESS then a HOLD_REPEAT every so often. Switches
+// that never send a release can't be held, so holds are only recognised once
+// the controller has sent one. No allocation, and O(1) per event.
+// only use this from the jack realtime thread
+class GestureEngine {
+public:
+    GestureEngine();
+    void setTimes(const GestureTimes &times, jack_nframes_t sampleRate);
+    // which switches have gestures and what they do, call before it's used
+    void setProfile(const DeviceProfile &profile);
+    // a decoded press or release at absolute frame `frame`, writes the
+    // gestures to out and returns how many there are (at most 2)
+    int input(const ControlEvent &e, uint64_t frame, ControlEvent *out);
+    // gestures due before cycleEnd, call until it returns false, the time is
+    // the offset from cycleStart
+    bool poll(uint64_t cycleStart, uint64_t cycleEnd, ControlEvent &out);
+private:
+    static const int GESTURES = 4;
+    class Switch {
+    public:
+        // the profile's bindings for each gesture
+        bool bound[GESTURES] = {};
+        ControlEvent::Action action[GESTURES];
+        unsigned int index[GESTURES];
+        // a TAP that's waiting to see if it turns into something else
+        bool tapPending = false;
+        uint64_t pressFrame = 0, tapDue = 0;
+        bool held = false;
+        bool holdSent = false;
+        uint64_t nextHold = 0;
+        ControlEvent press;
+    };
+    // one per action & index
+    static const int MAX_SWITCHES = 40;
+    Switch switches[MAX_SWITCHES];
+    uint64_t doubleTapFrames = 0, longPressFrames = 0, repeatFrames = 0;
+    bool sendsReleases = false;
+    bool wantsDoubleTap(const Switch &s);
+    bool wantsHold(const Switch &s);
+    // the switch's press turned into a gesture, at a frame in the cycle
+    ControlEvent gesture(const Switch &s, ControlEvent::Gesture g, jack_nframes_t time);
+    ControlEvent holdGesture(Switch &s, jack_nframes_t time);
+};
+
+#endif /* GESTURE_H */
@@ -0,0 +1,128 @@
+/*
+ * File:   Log.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "Log.h"
+#include "Metrics.h"
+#include "Realtime.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdarg>
+
+// bounded multi producer ring, see Dmitry Vyukov's MPMC queue. Each slot has
+// a sequence number that tells producers & the consumer whose turn it is.
+static const size_t LOG_SLOTS = 512;
+static const size_t LOG_MESSAGE_SIZE = 240;
+
+class LogSlot {
+public:
+    std::atomic<size_t> sequence;
+    int level;
+    char message[LOG_MESSAGE_SIZE];
+};
+
+class LogRing {
+public:
+    LogRing() {
+        for (size_t i=0; i<LOG_SLOTS; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    LogSlot slots[LOG_SLOTS];
+};
+
+static LogRing ring;
+static std::atomic<size_t> writePos{0};
+static size_t readPos = 0;
+static std::atomic<int> logLevel{LOG_LEVEL_INFO};
+static std::atomic<unsigned long> dropped{0};
+static std::atomic<bool> logQuit{false};
+static std::thread logThread;
+static Counter *droppedCounter = NULL;
+
+// write out everything in the ring, only called from one thread at a time
+static void drain() {
+    static const char *prefixes[] = {"error: ", "warning: ", "", "debug: "};
+    bool wrote = false;
+    unsigned long lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost > 0) {
+        fprintf(stdout, "warning: %lu log messages dropped\n", lost);
+        if (droppedCounter) droppedCounter->inc(lost);
+        wrote = true;
+    }
+    while (true) {
+        LogSlot &slot = ring.slots[readPos % LOG_SLOTS];
+        if (slot.sequence.load(std::memory_order_acquire) != readPos + 1) break;
+        fputs(prefixes[slot.level], stdout);
+        fputs(slot.message, stdout);
+        fputc('\n', stdout);
+        slot.sequence.store(readPos + LOG_SLOTS, std::memory_order_release);
+        readPos++;
+        wrote = true;
+    }
+    // one flush per batch instead of one per line
+    if (wrote) fflush(stdout);
+}
+
+void logStart() {
+    droppedCounter = metrics().counter("modmidi_log_dropped_total", "Log messages dropped because the log ring was full");
+    logQuit = false;
+    logThread = std::thread([] {
+        threadPolicies().apply("log");
+        while (!logQuit) {
+            drain();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        drain();
+    });
+}
+
+void logStop() {
+    logQuit = true;
+    if (logThread.joinable()) {
+        logThread.join();
+    } else {
+        drain();
+    }
+}
+
+void logSetLevel(int level) {
+    logLevel = level;
+}
+
+bool logEnabled(int level) {
+    return level <= logLevel.load(std::memory_order_relaxed);
+}
+
+void logWrite(int level, const char *format, ...) {
+    if (!logEnabled(level)) return;
+    // claim a slot
+    size_t pos = writePos.load(std::memory_order_relaxed);
+    LogSlot *slot;
+    while (true) {
+        slot = &ring.slots[pos % LOG_SLOTS];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence == pos) {
+            if (writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (sequence < pos) {
+            // the ring is full
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = writePos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->level = level;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(slot->message, LOG_MESSAGE_SIZE, format, args);
+    va_end(args);
+    // hand the slot to the consumer
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
@@ -0,0 +1,43 @@
+/*
+ * File:   Log.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+// Log calls format into a preallocated lock-free ring and return right away,
+// a background thread writes the messages out. Nothing here allocates, locks
+// or blocks, so it's safe to log from the jack realtime thread. If the ring is
+// full the message is dropped and counted.
+
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+
+// statements above this level are compiled out entirely, e.g. build with
+// CXXFLAGS=-DMODMIDI_LOG_MAX_LEVEL=2 to remove all debug logging
+#ifndef MODMIDI_LOG_MAX_LEVEL
+#define MODMIDI_LOG_MAX_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+void logStart();
+void logStop();
+void logSetLevel(int level);
+bool logEnabled(int level);
+void logWrite(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+#define LOG_ERROR(...) logWrite(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...) logWrite(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(...) logWrite(LOG_LEVEL_INFO, __VA_ARGS__)
+#if MODMIDI_LOG_MAX_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) do { if (logEnabled(LOG_LEVEL_DEBUG)) logWrite(LOG_LEVEL_DEBUG, __VA_ARGS__); } while(0)
+#else
+#define LOG_DEBUG(...) do {} while(0)
+#endif
+
+#endif /* LOG_H */
+
@@ -0,0 +1,137 @@
+/*
+ * File:   Metrics.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "Metrics.h"
+
+#include <map>
+#include <vector>
+
+void Histogram::observe(uint64_t value) {
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && value > ((uint64_t)1 << bucket)) bucket++;
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::quantile(double q) const {
+    uint64_t total = getCount();
+    if (total == 0) return 0;
+    uint64_t target = (uint64_t)(q * (double)total);
+    uint64_t seen = 0;
+    for (int i=0; i<BUCKETS; i++) {
+        seen += getBucket(i);
+        if (seen > target || seen == total) return (uint64_t)1 << i;
+    }
+    return (uint64_t)1 << (BUCKETS - 1);
+}
+
+void *MetricsRegistry::find(Type type, const std::string &name, const std::string &labels) {
+    for (auto &e : entries) {
+        if (e.type == type && e.name == name && e.labels == labels) return e.metric;
+    }
+    return NULL;
+}
+
+Counter *MetricsRegistry::counter(std::string name, std::string help, std::string labels) {
+    std::lock_guard<std::mutex> guard(m_entries);
+    void *existing = find(COUNTER, name, labels);
+    if (existing) return (Counter *)existing;
+    counters.emplace_back();
+    Entry e;
+    e.name = name;
+    e.help = help;
+    e.labels = labels;
+    e.type = COUNTER;
+    e.metric = &counters.back();
+    entries.push_back(e);
+    return &counters.back();
+}
+
+Gauge *MetricsRegistry::gauge(std::string name, std::string help, std::string labels) {
+    std::lock_guard<std::mutex> guard(m_entries);
+    void *existing = find(GAUGE, name, labels);
+    if (existing) return (Gauge *)existing;
+    gauges.emplace_back();
+    Entry e;
+    e.name = name;
+    e.help = help;
+    e.labels = labels;
+    e.type = GAUGE;
+    e.metric = &gauges.back();
+    entries.push_back(e);
+    return &gauges.back();
+}
+
+Histogram *MetricsRegistry::histogram(std::string name, std::string help, std::string labels) {
+    std::lock_guard<std::mutex> guard(m_entries);
+    void *existing = find(HISTOGRAM, name, labels);
+    if (existing) return (Histogram *)existing;
+    histograms.emplace_back();
+    Entry e;
+    e.name = name;
+    e.help = help;
+    e.labels = labels;
+    e.type = HISTOGRAM;
+    e.metric = &histograms.back();
+    entries.push_back(e);
+    return &histograms.back();
+}
+
+static std::string withLabels(const std::string &labels, const std::string &extra = "") {
+    if (labels.size() == 0 && extra.size() == 0) return "";
+    if (labels.size() == 0) return "{" + extra + "}";
+    if (extra.size() == 0) return "{" + labels + "}";
+    return "{" + labels + "," + extra + "}";
+}
+
+std::string MetricsRegistry::render() {
+    std::lock_guard<std::mutex> guard(m_entries);
+    // group entries by name so HELP & TYPE are only written once per family
+    std::vector<std::string> names;
+    std::map<std::string, std::vector<Entry*>> families;
+    for (auto &e : entries) {
+        if (families.find(e.name) == families.end()) names.push_back(e.name);
+        families[e.name].push_back(&e);
+    }
+    std::string out;
+    for (auto &name : names) {
+        auto &family = families[name];
+        Entry *first = family.front();
+        static const char *typeNames[] = {"counter", "gauge", "histogram"};
+        out += "# HELP " + name + " " + first->help + "\n";
+        out += "# TYPE " + name + " " + typeNames[first->type] + "\n";
+        for (Entry *e : family) {
+            switch(e->type) {
+                case COUNTER:
+                    out += name + withLabels(e->labels) + " " + std::to_string(((Counter *)e->metric)->get()) + "\n";
+                    break;
+                case GAUGE:
+                    out += name + withLabels(e->labels) + " " + std::to_string(((Gauge *)e->metric)->get()) + "\n";
+                    break;
+                case HISTOGRAM: {
+                    Histogram *h = (Histogram *)e->metric;
+                    uint64_t cumulative = 0;
+                    for (int i=0; i<Histogram::BUCKETS; i++) {
+                        cumulative += h->getBucket(i);
+                        std::string le = (i == Histogram::BUCKETS - 1) ? "+Inf" : std::to_string((uint64_t)1 << i);
+                        out += name + "_bucket" + withLabels(e->labels, "le=\"" + le + "\"") + " " + std::to_string(cumulative) + "\n";
+                    }
+                    out += name + "_sum" + withLabels(e->labels) + " " + std::to_string(h->getSum()) + "\n";
+                    out += name + "_count" + withLabels(e->labels) + " " + std::to_string(h->getCount()) + "\n";
+                    break;
+                }
+            }
+        }
+    }
+    return out;
+}
+
+MetricsRegistry &metrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
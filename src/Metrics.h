@@ -0,0 +1,89 @@
+/*
+ * File:   Metrics.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+
+// Metrics are registered once (which takes a lock) and then updated with
+// relaxed atomics only, so they're safe to touch from the jack realtime thread.
+
+class Counter {
+public:
+    void inc(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+class Gauge {
+public:
+    void set(int64_t v) { value.store(v, std::memory_order_relaxed); }
+    void add(int64_t v) { value.fetch_add(v, std::memory_order_relaxed); }
+    int64_t get() const { return value.load(std::memory_order_relaxed); }
+private:
+    std::atomic<int64_t> value{0};
+};
+
+// histogram with power of two buckets: bucket i counts values <= 2^i, and
+// the last bucket catches everything bigger
+class Histogram {
+public:
+    static const int BUCKETS = 25;
+    void observe(uint64_t value);
+    uint64_t getBucket(int i) const { return buckets[i].load(std::memory_order_relaxed); }
+    uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+    uint64_t getSum() const { return sum.load(std::memory_order_relaxed); }
+    // estimate a quantile (0-1) from the buckets, returns the bucket's upper bound
+    uint64_t quantile(double q) const;
+private:
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+};
+
+// this class is thread safe
+class MetricsRegistry {
+public:
+    // these return the existing metric if the name & labels were already
+    // registered, labels are in Prometheus form, e.g. command="get_bank"
+    Counter *counter(std::string name, std::string help, std::string labels = "");
+    Gauge *gauge(std::string name, std::string help, std::string labels = "");
+    Histogram *histogram(std::string name, std::string help, std::string labels = "");
+
+    // render everything in the Prometheus text exposition format
+    std::string render();
+private:
+    enum Type {
+        COUNTER,
+        GAUGE,
+        HISTOGRAM
+    };
+    class Entry {
+    public:
+        std::string name, help, labels;
+        Type type;
+        void *metric;
+    };
+    void *find(Type type, const std::string &name, const std::string &labels);
+    std::mutex m_entries;
+    std::deque<Entry> entries;
+    // deques so that pointers stay valid as metrics are added
+    std::deque<Counter> counters;
+    std::deque<Gauge> gauges;
+    std::deque<Histogram> histograms;
+};
+
+MetricsRegistry &metrics();
+
+#endif /* METRICS_H */
+
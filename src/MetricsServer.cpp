@@ -0,0 +1,114 @@
+/*
+ * File:   MetricsServer.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "MetricsServer.h"
+#include "Metrics.h"
+#include "FlightRecorder.h"
+#include "Log.h"
+#include "Realtime.h"
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+MetricsServer::MetricsServer() {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(int port) {
+    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSocket == -1) {
+        LOG_ERROR("Could not create metrics socket");
+        return false;
+    }
+    int flag = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+    // only listen on localhost, nothing here needs to be exposed to the network
+    struct sockaddr_in server;
+    memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server.sin_port = htons(port);
+    if (bind(listenSocket, (struct sockaddr *) &server, sizeof(server)) < 0 || listen(listenSocket, 4) < 0) {
+        LOG_ERROR("Unable to listen for metrics on port %d", port);
+        close(listenSocket);
+        listenSocket = -1;
+        return false;
+    }
+    LOG_INFO("Serving metrics on http://127.0.0.1:%d/metrics", port);
+    server_quit = false;
+    server_thread = std::thread([=] {threadWork();});
+    return true;
+}
+
+void MetricsServer::stop() {
+    server_quit = true;
+    if (server_thread.joinable()) server_thread.join();
+    if (listenSocket >= 0) {
+        close(listenSocket);
+        listenSocket = -1;
+    }
+}
+
+void MetricsServer::threadWork() {
+    threadPolicies().apply("metrics");
+    struct pollfd fd;
+    fd.fd = listenSocket;
+    fd.events = POLLIN;
+    while(!server_quit) {
+        // wake up regularly to check the quit flag
+        if (poll(&fd, 1, 500) <= 0) continue;
+        int client = accept(listenSocket, NULL, NULL);
+        if (client < 0) continue;
+        handleClient(client);
+        close(client);
+    }
+}
+
+void MetricsServer::handleClient(int socket) {
+    // read until the end of the request headers, we don't care about a body
+    std::string request;
+    char buffer[1024];
+    struct pollfd fd;
+    fd.fd = socket;
+    fd.events = POLLIN;
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        if (poll(&fd, 1, 1000) <= 0) return;
+        ssize_t bytes = recv(socket, buffer, sizeof(buffer), 0);
+        if (bytes <= 0) return;
+        request.append(buffer, bytes);
+    }
+    std::string status = "200 OK", body;
+    std::string contentType = "text/plain; version=0.0.4";
+    if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0) {
+        body = metrics().render();
+    } else if (request.compare(0, 11, "GET /trace ") == 0) {
+        body = flightRecorder().dump();
+        contentType = "application/json";
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+    std::string response = "HTTP/1.0 " + status + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+    size_t pos = 0;
+    while (pos < response.size()) {
+        ssize_t sent = send(socket, response.c_str() + pos, response.size() - pos, MSG_NOSIGNAL);
+        if (sent <= 0) return;
+        pos += sent;
+    }
+}
@@ -0,0 +1,31 @@
+/*
+ * File:   MetricsServer.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+
+// serves the metrics registry as Prometheus text on http://127.0.0.1:PORT/metrics
+class MetricsServer {
+public:
+    MetricsServer();
+    virtual ~MetricsServer();
+    bool start(int port);
+    void stop();
+private:
+    void threadWork();
+    void handleClient(int socket);
+    int listenSocket = -1;
+    std::thread server_thread;
+    std::atomic<bool> server_quit{false};
+};
+
+#endif /* METRICSSERVER_H */
+
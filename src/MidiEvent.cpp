@@ -18,6 +18,16 @@ MidiEvent::MidiEvent(const MidiEvent& orig) {
     this->data1 = orig.data1;
     this->data2 = orig.data2;
     this->eventType = orig.eventType;
+    this->time = orig.time;
+}
+
+MidiEvent& MidiEvent::operator=(const MidiEvent& orig) {
+    this->channel = orig.channel;
+    this->data1 = orig.data1;
+    this->data2 = orig.data2;
+    this->eventType = orig.eventType;
+    this->time = orig.time;
+    return *this;
 }
 
 MidiEvent::~MidiEvent() {
@@ -70,45 +80,50 @@ MidiEvent::MidiEvent(jack_midi_event_t jack_midi_event) {
 }
 
 std::vector<unsigned char> MidiEvent::getBuffer() {
-    std::vector<unsigned char> buf;
+    unsigned char buffer[3];
+    size_t size = toBytes(buffer);
+    return std::vector<unsigned char>(buffer, buffer + size);
+}
+
+size_t MidiEvent::toBytes(unsigned char *buffer) const {
     switch(eventType) {
         case EventType::CC:
-            buf.push_back(0xB0 + channel);
-            buf.push_back(data1);
-            buf.push_back(data2);
-            return buf;
+            buffer[0] = 0xB0 + channel;
+            buffer[1] = data1;
+            buffer[2] = data2;
+            return 3;
         case EventType::CHANNEL_AFTERTOUCH:
-            buf.push_back(0xD0 + channel);
-            buf.push_back(data1);
-            return buf;
+            buffer[0] = 0xD0 + channel;
+            buffer[1] = data1;
+            return 2;
         case EventType::NOTE_OFF:
-            buf.push_back(0x80 + channel);
-            buf.push_back(data1);
-            buf.push_back(data2);
-            return buf;
+            buffer[0] = 0x80 + channel;
+            buffer[1] = data1;
+            buffer[2] = data2;
+            return 3;
         case EventType::NOTE_ON:
-            buf.push_back(0x90 + channel);
-            buf.push_back(data1);
-            buf.push_back(data2);
-            return buf;
+            buffer[0] = 0x90 + channel;
+            buffer[1] = data1;
+            buffer[2] = data2;
+            return 3;
         case EventType::PITCH_WHEEL:
-            buf.push_back(0xE0 + channel);
-            buf.push_back(data1);
-            buf.push_back(data2);
-            return buf;
+            buffer[0] = 0xE0 + channel;
+            buffer[1] = data1;
+            buffer[2] = data2;
+            return 3;
         case EventType::POLYPHONIC_AFTERTOUCH:
-            buf.push_back(0xA0 + channel);
-            buf.push_back(data1);
-            buf.push_back(data2);
-            return buf;
+            buffer[0] = 0xA0 + channel;
+            buffer[1] = data1;
+            buffer[2] = data2;
+            return 3;
         case EventType::PROGRAM_CHANGE:
-            buf.push_back(0xC0 + channel);
-            buf.push_back(data1);
-            return buf;
+            buffer[0] = 0xC0 + channel;
+            buffer[1] = data1;
+            return 2;
         case EventType::OTHER:
         default:
-            // return an empty buffer since we don't know how to deal with these types
-            return buf;
+            // nothing since we don't know how to deal with these types
+            return 0;
     }
 }
 
@@ -17,10 +17,14 @@ class MidiEvent {
 public:
     MidiEvent();
     MidiEvent(const MidiEvent& orig);
+    MidiEvent& operator=(const MidiEvent& orig);
     MidiEvent(jack_midi_event_t jack_midi_event);
     virtual ~MidiEvent();
     void print();
     std::vector<unsigned char> getBuffer();
+    // same as getBuffer() without allocating, buffer needs room for 3 bytes,
+    // returns the number of bytes written
+    size_t toBytes(unsigned char *buffer) const;
     
     unsigned char channel = 0;
     
@@ -0,0 +1,76 @@
+/*
+ * File:   MidiThru.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "MidiThru.h"
+
+bool ThruFilter::parse(std::string types) {
+    static const struct {
+        const char *name;
+        unsigned int mask;
+    } names[] = {
+        {"notes", NOTES},
+        {"poly-pressure", POLY_PRESSURE},
+        {"cc", CC},
+        {"program", PROGRAM},
+        {"pressure", CHANNEL_PRESSURE},
+        {"pitch", PITCH},
+        {"sysex", SYSEX},
+        {"clock", REALTIME},
+        {"common", COMMON},
+        {"all", ALL},
+        {"none", 0}
+    };
+    mask = 0;
+    size_t start = 0;
+    while (start <= types.size()) {
+        size_t comma = types.find(',', start);
+        if (comma == std::string::npos) comma = types.size();
+        std::string name = types.substr(start, comma - start);
+        bool found = false;
+        for (auto &n : names) {
+            if (name == n.name) {
+                mask |= n.mask;
+                found = true;
+            }
+        }
+        if (!found) return false;
+        start = comma + 1;
+    }
+    return true;
+}
+
+bool ThruFilter::enabled() const {
+    return mask != 0;
+}
+
+bool ThruFilter::passes(const unsigned char *data, size_t size) const {
+    if (size == 0) return false;
+    unsigned char status = data[0];
+    if (status < 0x80) return false;
+    switch (status & 0xF0) {
+        case 0x80:
+        case 0x90:
+            return mask & NOTES;
+        case 0xA0:
+            return mask & POLY_PRESSURE;
+        case 0xB0:
+            return mask & CC;
+        case 0xC0:
+            return mask & PROGRAM;
+        case 0xD0:
+            return mask & CHANNEL_PRESSURE;
+        case 0xE0:
+            return mask & PITCH;
+    }
+    if (status == 0xF0) return mask & SYSEX;
+    if (status >= 0xF8) return mask & REALTIME;
+    return mask & COMMON;
+}
+
+const char *ThruFilter::typeNames() {
+    return "notes, poly-pressure, cc, program, pressure, pitch, sysex, clock, common, all";
+}
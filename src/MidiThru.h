@@ -0,0 +1,44 @@
+/*
+ * File:   MidiThru.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef MIDITHRU_H
+#define MIDITHRU_H
+
+#include <string>
+#include <stddef.h>
+
+// Decides which of a controller's input messages are copied straight through
+// to its output port. Messages ModMidi uses itself are never passed on.
+class ThruFilter {
+public:
+    enum Type {
+        NOTES = 1 << 0,
+        POLY_PRESSURE = 1 << 1,
+        CC = 1 << 2,
+        PROGRAM = 1 << 3,
+        CHANNEL_PRESSURE = 1 << 4,
+        PITCH = 1 << 5,
+        SYSEX = 1 << 6,
+        // clock, start, stop etc.
+        REALTIME = 1 << 7,
+        // the rest of the system common messages
+        COMMON = 1 << 8,
+        ALL = (1 << 9) - 1
+    };
+    // parses a comma separated list like "notes,cc,clock", returns false if
+    // a name isn't known
+    bool parse(std::string types);
+    bool enabled() const;
+    // safe to call from the jack realtime thread
+    bool passes(const unsigned char *data, size_t size) const;
+    static const char *typeNames();
+private:
+    unsigned int mask = 0;
+};
+
+#endif /* MIDITHRU_H */
+
@@ -0,0 +1,265 @@
+/*
+ * File:   ModConnection.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "ModConnection.h"
+#include "Log.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/poll.h>
+
+// how long to wait on one address before also trying the next, from RFC 8305
+static const int CONNECTION_ATTEMPT_DELAY = 250;
+
+class Address {
+public:
+    sockaddr_storage addr;
+    socklen_t length;
+    int family;
+};
+
+// shared with the resolver thread, which may outlive a timed out caller
+class Resolution {
+public:
+    std::mutex m_done;
+    std::condition_variable c_done;
+    bool done = false;
+    int result = 0;
+    std::vector<Address> addresses;
+};
+
+static long msecSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int msecUntil(std::chrono::steady_clock::time_point end) {
+    long msec = std::chrono::duration_cast<std::chrono::milliseconds>(end - std::chrono::steady_clock::now()).count();
+    return msec < 0 ? 0 : (int)msec;
+}
+
+static std::string addressString(const Address &a) {
+    char host[256];
+    if (getnameinfo((const sockaddr *)&a.addr, a.length, host, sizeof(host), NULL, 0, NI_NUMERICHOST)) return "?";
+    return host;
+}
+
+static bool resolve(std::string hostname, int port, std::chrono::steady_clock::time_point end, std::vector<Address> &addresses) {
+    std::shared_ptr<Resolution> resolution = std::make_shared<Resolution>();
+    std::string service = std::to_string(port);
+    std::thread([resolution, hostname, service] {
+        addrinfo hints, *infoptr;
+        memset(&hints, 0, sizeof hints);
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        int result = getaddrinfo(hostname.c_str(), service.c_str(), &hints, &infoptr);
+        std::vector<Address> found;
+        if (!result) {
+            for (addrinfo *p = infoptr; p != NULL; p = p->ai_next) {
+                Address a;
+                memcpy(&a.addr, p->ai_addr, p->ai_addrlen);
+                a.length = p->ai_addrlen;
+                a.family = p->ai_family;
+                found.push_back(a);
+            }
+            freeaddrinfo(infoptr);
+        }
+        std::lock_guard<std::mutex> guard(resolution->m_done);
+        resolution->result = result;
+        resolution->addresses = found;
+        resolution->done = true;
+        resolution->c_done.notify_all();
+    }).detach();
+
+    std::unique_lock<std::mutex> lock(resolution->m_done);
+    if (!resolution->c_done.wait_until(lock, end, [&] {return resolution->done;})) {
+        LOG_ERROR("Timed out looking up hostname %s", hostname.c_str());
+        return false;
+    }
+    if (resolution->result) {
+        LOG_ERROR("Unable to get IP address for hostname: %s", gai_strerror(resolution->result));
+        return false;
+    }
+    // alternate address families, keeping the resolver's preferred one first
+    std::vector<Address> first, second;
+    for (auto &a : resolution->addresses) {
+        if (a.family == resolution->addresses.front().family) {
+            first.push_back(a);
+        } else {
+            second.push_back(a);
+        }
+    }
+    addresses.clear();
+    for (size_t i=0; i<first.size() || i<second.size(); i++) {
+        if (i < first.size()) addresses.push_back(first[i]);
+        if (i < second.size()) addresses.push_back(second[i]);
+    }
+    return addresses.size() > 0;
+}
+
+// start a non-blocking connect, returns the socket or -1
+static int startConnect(const Address &a) {
+    int s = socket(a.family, SOCK_STREAM, 0);
+    if (s < 0) return -1;
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+    if (connect(s, (const sockaddr *)&a.addr, a.length) < 0 && errno != EINPROGRESS) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+// check a socket poll() says is ready, returns true if it's connected
+static bool finishConnect(int s) {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(s, SOL_SOCKET, SO_ERROR, &error, &length) < 0) return false;
+    return error == 0;
+}
+
+static void setBlocking(int s) {
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) & ~O_NONBLOCK);
+}
+
+// race the addresses, returns the index of the first one to connect or -1
+static int race(const std::vector<Address> &addresses, std::chrono::steady_clock::time_point end, int &winner) {
+    std::vector<pollfd> fds;
+    std::vector<size_t> fdAddress;
+    size_t next = 0;
+    int result = -1;
+    winner = -1;
+    while (result < 0) {
+        // start the next attempt if nothing is running or the last one is slow
+        if (next < addresses.size()) {
+            int s = startConnect(addresses[next]);
+            if (s >= 0) {
+                pollfd fd;
+                fd.fd = s;
+                fd.events = POLLOUT;
+                fd.revents = 0;
+                fds.push_back(fd);
+                fdAddress.push_back(next);
+            }
+            next++;
+        }
+        if (fds.size() == 0) {
+            if (next < addresses.size()) continue;
+            break;
+        }
+        int timeout = msecUntil(end);
+        if (timeout == 0) break;
+        if (next < addresses.size() && timeout > CONNECTION_ATTEMPT_DELAY) timeout = CONNECTION_ATTEMPT_DELAY;
+        if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) break;
+        for (size_t i=0; i<fds.size();) {
+            if (fds[i].revents == 0) {
+                i++;
+                continue;
+            }
+            if (finishConnect(fds[i].fd)) {
+                result = fdAddress[i];
+                winner = fds[i].fd;
+                fds.erase(fds.begin() + i);
+                fdAddress.erase(fdAddress.begin() + i);
+                break;
+            }
+            // this address failed, move on to the next one right away
+            LOG_INFO("Unable to connect to %s", addressString(addresses[fdAddress[i]]).c_str());
+            close(fds[i].fd);
+            fds.erase(fds.begin() + i);
+            fdAddress.erase(fdAddress.begin() + i);
+        }
+        if (msecUntil(end) == 0) break;
+    }
+    // close the attempts that lost
+    for (auto &fd : fds) {
+        close(fd.fd);
+    }
+    return result;
+}
+
+// connect the sockets to one address in parallel
+static bool connectAll(const Address &a, int count, int *sockets, std::chrono::steady_clock::time_point end) {
+    std::vector<pollfd> fds;
+    for (int i=0; i<count; i++) {
+        sockets[i] = startConnect(a);
+        if (sockets[i] < 0) {
+            for (int j=0; j<i; j++) close(sockets[j]);
+            return false;
+        }
+        pollfd fd;
+        fd.fd = sockets[i];
+        fd.events = POLLOUT;
+        fd.revents = 0;
+        fds.push_back(fd);
+    }
+    int remaining = count;
+    bool ok = true;
+    while (remaining > 0 && ok) {
+        int timeout = msecUntil(end);
+        if (timeout == 0 || (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR)) {
+            ok = false;
+            break;
+        }
+        for (auto &fd : fds) {
+            if (fd.fd < 0 || fd.revents == 0) continue;
+            if (!finishConnect(fd.fd)) ok = false;
+            // a negative fd is ignored by poll()
+            fd.fd = -1;
+            remaining--;
+        }
+    }
+    if (!ok) {
+        for (int i=0; i<count; i++) close(sockets[i]);
+    }
+    return ok;
+}
+
+bool connectToMod(std::string hostname, int port, int count, int *sockets, std::chrono::milliseconds deadline, ConnectTimings &timings) {
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + deadline;
+    std::vector<Address> addresses;
+    if (!resolve(hostname, port, end, addresses)) return false;
+    timings.dnsMsec = msecSince(start);
+
+    auto raceStart = std::chrono::steady_clock::now();
+    int first;
+    int index = race(addresses, end, first);
+    if (index < 0) {
+        if (msecUntil(end) == 0) {
+            LOG_ERROR("Timed out connecting to %s after %ld msec", hostname.c_str(), (long)deadline.count());
+        } else {
+            LOG_ERROR("No address for %s accepted a connection", hostname.c_str());
+        }
+        return false;
+    }
+    timings.raceMsec = msecSince(raceStart);
+    timings.address = addressString(addresses[index]);
+
+    // the race winner is the first connection, open the rest in parallel
+    auto connectStart = std::chrono::steady_clock::now();
+    sockets[0] = first;
+    if (count > 1 && !connectAll(addresses[index], count - 1, sockets + 1, end)) {
+        LOG_ERROR("Unable to open all connections to %s", timings.address.c_str());
+        close(first);
+        return false;
+    }
+    timings.connectMsec = msecSince(connectStart);
+    for (int i=0; i<count; i++) {
+        setBlocking(sockets[i]);
+    }
+    timings.totalMsec = msecSince(start);
+    return true;
+}
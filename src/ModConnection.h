@@ -0,0 +1,31 @@
+/*
+ * File:   ModConnection.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef MODCONNECTION_H
+#define MODCONNECTION_H
+
+#include <string>
+#include <chrono>
+
+class ConnectTimings {
+public:
+    long dnsMsec = 0;
+    long raceMsec = 0;
+    long connectMsec = 0;
+    long totalMsec = 0;
+    std::string address;
+};
+
+// Open count connections to the Mod. The hostname is resolved for both IPv4
+// and IPv6 on a helper thread, the addresses are raced with staggered
+// non-blocking connects (happy eyeballs), and the rest of the connections are
+// opened to the winning address in parallel. Everything has to finish before
+// the deadline. The sockets are left in blocking mode.
+bool connectToMod(std::string hostname, int port, int count, int *sockets, std::chrono::milliseconds deadline, ConnectTimings &timings);
+
+#endif /* MODCONNECTION_H */
+
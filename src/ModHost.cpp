@@ -0,0 +1,282 @@
+/*
+ * File:   ModHost.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "ModHost.h"
+#include "Utilities.h"
+#include "Log.h"
+#include "Clock.h"
+#include "Realtime.h"
+
+#include <cmath>
+
+ModHost::ModHost(std::string hostname) {
+    this->hostname = hostname;
+    std::string labels = "host=\"" + hostname + "\"";
+    MetricsRegistry &m = metrics();
+    metricConnects = m.counter("modmidi_host_connects_total", "Successful connections to each Mod", labels);
+    metricCommands = m.counter("modmidi_host_commands_total", "Commands sent to each Mod", labels);
+    metricResyncs = m.counter("modmidi_host_tempo_resyncs_total", "Times a follower's tempo had drifted from the primary", labels);
+}
+
+ModHost::~ModHost() {
+    stop();
+}
+
+std::string ModHost::getHostname() {
+    return hostname;
+}
+
+void ModHost::setSimulate(bool simulate) {
+    this->simulate = simulate;
+}
+
+void ModHost::setTempoInterval(int msec) {
+    tempoPublisher.setMinInterval(msec);
+}
+
+void ModHost::setMaxAge(std::chrono::milliseconds maxAge) {
+    commandQueue.setMaxAge(maxAge);
+}
+
+void ModHost::setRoutes(std::vector<std::string> routes) {
+    routeList = routes;
+}
+
+void ModHost::setExpressions(ExpressionMap *expressions, int rate) {
+    this->expressions = expressions;
+    parameterPublisher.setMaxRate(rate);
+}
+
+bool ModHost::routes(const std::string &controller) {
+    if (routeList.size() == 0) return true;
+    for (auto &r : routeList) {
+        if (r == controller) return true;
+    }
+    return false;
+}
+
+bool ModHost::connect(std::chrono::milliseconds timeout) {
+    // one connection for each of the scheduler's lanes
+    int sockets[CommandScheduler::PRIORITY_COUNT];
+    const int socketCount = CommandScheduler::PRIORITY_COUNT;
+    if (!connectToMod(hostname, 7777, socketCount, sockets, timeout, timings)) {
+        LOG_ERROR("Unable to connect to Mod Duo %s", hostname.c_str());
+        return false;
+    }
+    LOG_INFO("Connected to Mod Duo %s using IP address %s in %ld msec (lookup %ld, race %ld, other connections %ld)",
+            hostname.c_str(), timings.address.c_str(), timings.totalMsec, timings.dnsMsec, timings.raceMsec, timings.connectMsec);
+    metricConnects->inc();
+    for (int i=0; i<socketCount; i++) {
+        scheduler.setSocket((CommandScheduler::Priority)i, sockets[i]);
+    }
+    return true;
+}
+
+const ConnectTimings &ModHost::getTimings() {
+    return timings;
+}
+
+void ModHost::start(bool follower) {
+    tempoPublisher.start([this] (double tempo) {return sendTempo(tempo);});
+    parameterPublisher.start(expressions, [this] (const std::string &port, double value) {return sendParameter(port, value);});
+    if (follower) {
+        follower_quit = false;
+        follower_thread = std::thread([=] {followerThreadWork();});
+    }
+}
+
+void ModHost::startSynchronous() {
+    synchronous = true;
+}
+
+void ModHost::stop() {
+    follower_quit = true;
+    if (follower_thread.joinable()) follower_thread.join();
+    tempoPublisher.stop();
+    parameterPublisher.stop();
+    scheduler.closeSockets();
+}
+
+CommandScheduler &ModHost::getScheduler() {
+    return scheduler;
+}
+
+void ModHost::submit(ModCommand command) {
+    if (synchronous) {
+        runCommand(command);
+        return;
+    }
+    commandQueue.push(command);
+}
+
+void ModHost::setTempo(double bpm) {
+    {
+        std::lock_guard<std::mutex> guard(m_tempo);
+        if (bpm == targetBPM) return;
+        targetBPM = bpm;
+    }
+    if (synchronous) {
+        sendTempo(bpm);
+        return;
+    }
+    tempoPublisher.publish(bpm);
+}
+
+void ModHost::syncTempo(double bpm) {
+    std::lock_guard<std::mutex> guard(m_tempo);
+    targetBPM = bpm;
+}
+
+// called from the tempo publisher's thread
+bool ModHost::sendTempo(double bpm) {
+    bool status = true;
+    scheduler.acquire(CommandScheduler::TEMPO);
+    if (simulate) {
+        currentClock().sleepFor(std::chrono::milliseconds(20));
+        LOG_INFO("sent new tempo to %s: %f", hostname.c_str(), bpm);
+    } else {
+        status = setBPM(scheduler.getSocket(CommandScheduler::TEMPO), scheduler.getSocketMutex(CommandScheduler::TEMPO), bpm);
+    }
+    scheduler.release(CommandScheduler::TEMPO);
+    return status;
+}
+
+// called from the parameter publisher's thread
+bool ModHost::sendParameter(const std::string &port, double value) {
+    bool status = true;
+    scheduler.acquire(CommandScheduler::PARAMETER);
+    if (simulate) {
+        currentClock().sleepFor(std::chrono::milliseconds(5));
+        LOG_DEBUG("set %s on %s to %f", port.c_str(), hostname.c_str(), value);
+    } else {
+        status = setParameter(scheduler.getSocket(CommandScheduler::PARAMETER), scheduler.getSocketMutex(CommandScheduler::PARAMETER), port, value);
+    }
+    scheduler.release(CommandScheduler::PARAMETER);
+    return status;
+}
+
+bool ModHost::runCommand(const ModCommand &command) {
+    metricCommands->inc();
+    if (simulate) {
+        currentClock().sleepFor(std::chrono::milliseconds(command.type == ModCommand::LOAD_PEDALBOARD ? 1000 : 10));
+        return true;
+    }
+    int socket = scheduler.getSocket(CommandScheduler::INTERACTIVE);
+    std::mutex *socketMutex = scheduler.getSocketMutex(CommandScheduler::INTERACTIVE);
+    if (command.type == ModCommand::LOAD_PEDALBOARD) {
+        // the primary's index means nothing here, go by the bundle
+        unsigned int index;
+        int bank;
+        if (!findBundle(command.bundle, index, bank)) {
+            LOG_WARN("%s doesn't have pedalboard %s, not loading it", hostname.c_str(), command.bundle.c_str());
+            return false;
+        }
+        if (!loadPedalboard(socket, socketMutex, index, bank)) return false;
+        currentBundle = command.bundle;
+        // the unit has moved to the other bank
+        if (bank >= 0) getPedalboardList(socket, socketMutex, pedalboardList, NULL);
+        return true;
+    } else {
+        if (command.bundle != currentBundle) {
+            LOG_WARN("%s isn't on pedalboard %s, not loading preset %u", hostname.c_str(), command.bundle.c_str(), command.index);
+            return false;
+        }
+        return loadPreset(socket, socketMutex, command.index);
+    }
+}
+
+// called with the interactive lane held
+bool ModHost::findBundle(const std::string &bundle, unsigned int &index, int &bank) {
+    if (bundle.size() == 0) return false;
+    for (size_t i=0; i<pedalboardList.size(); i++) {
+        if (pedalboardList[i].bundle != bundle) continue;
+        index = i;
+        bank = -1;
+        return true;
+    }
+    // it may be in one of the unit's other banks
+    int socket = scheduler.getSocket(CommandScheduler::INTERACTIVE);
+    std::mutex *socketMutex = scheduler.getSocketMutex(CommandScheduler::INTERACTIVE);
+    std::vector<ModBank> banks;
+    int currentBank;
+    if (!getBankList(socket, socketMutex, banks, currentBank)) return false;
+    for (auto &b : banks) {
+        std::vector<ModPedalboard> list;
+        if (!getPedalboardList(socket, socketMutex, list, NULL, b.id)) continue;
+        for (size_t i=0; i<list.size(); i++) {
+            if (list[i].bundle != bundle) continue;
+            index = i;
+            bank = b.id;
+            return true;
+        }
+    }
+    return false;
+}
+
+// a follower's status refresh: its own bank & pedalboard, and its tempo
+void ModHost::refreshStatus() {
+    if (!simulate) {
+        int socket = scheduler.getSocket(CommandScheduler::BACKGROUND);
+        std::mutex *socketMutex = scheduler.getSocketMutex(CommandScheduler::BACKGROUND);
+        scheduler.acquire(CommandScheduler::BACKGROUND);
+        std::vector<ModPedalboard> list;
+        int pedalboard = -1, preset = -1;
+        unsigned int offset = 0;
+        if (getPedalboardList(socket, socketMutex, list, NULL) && getCurrentPedalboardAndPreset(socket, socketMutex, list, pedalboard, preset, offset, NULL)) {
+            pedalboardList = list;
+            currentBundle = pedalboard >= 0 ? list[pedalboard].bundle : "";
+        } else {
+            LOG_ERROR("Error getting current bank from %s", hostname.c_str());
+        }
+        scheduler.release(CommandScheduler::BACKGROUND);
+    }
+    checkTempo();
+}
+
+// the primary decides the tempo, put the follower back if it drifted
+void ModHost::checkTempo() {
+    double target;
+    {
+        std::lock_guard<std::mutex> guard(m_tempo);
+        target = targetBPM;
+    }
+    if (target <= 0 || simulate) return;
+    double bpm;
+    scheduler.acquire(CommandScheduler::BACKGROUND);
+    bool status = getCurrentBPM(scheduler.getSocket(CommandScheduler::BACKGROUND), scheduler.getSocketMutex(CommandScheduler::BACKGROUND), bpm, NULL);
+    scheduler.release(CommandScheduler::BACKGROUND);
+    if (!status) {
+        LOG_ERROR("Error getting current BPM from %s", hostname.c_str());
+    } else if (std::fabs(bpm - target) > 0.05) {
+        metricResyncs->inc();
+        tempoPublisher.publish(target);
+    }
+}
+
+void ModHost::followerThreadWork() {
+    threadPolicies().apply("follower");
+    ModCommand command;
+    // know where this unit is before the first command comes in
+    refreshStatus();
+    auto nextCheck = currentClock().now() + std::chrono::seconds(10);
+    while(!follower_quit) {
+        if (commandQueue.pop(command)) {
+            scheduler.acquire(CommandScheduler::INTERACTIVE);
+            if (!runCommand(command)) {
+                LOG_ERROR("Unable to send command to %s", hostname.c_str());
+            }
+            scheduler.release(CommandScheduler::INTERACTIVE);
+            continue;
+        }
+        if (currentClock().now() >= nextCheck) {
+            refreshStatus();
+            nextCheck = currentClock().now() + std::chrono::seconds(10);
+        }
+        currentClock().sleepFor(std::chrono::milliseconds(1));
+    }
+    LOG_INFO("Follower thread for %s exiting", hostname.c_str());
+}
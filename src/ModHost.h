@@ -0,0 +1,94 @@
+/*
+ * File:   ModHost.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef MODHOST_H
+#define MODHOST_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <mutex>
+
+#include "CommandScheduler.h"
+#include "CommandQueue.h"
+#include "TempoPublisher.h"
+#include "ParameterPublisher.h"
+#include "ModConnection.h"
+#include "Metrics.h"
+#include "Utilities.h"
+
+// One Mod unit: its connections, command lanes, tempo and parameter publishers. The first
+// host is the primary, whose state the controllers show. Any others are
+// followers that replay the commands routed to them from their own thread,
+// so a slow unit never holds up the rest, and keep their tempo in step with
+// the primary. A follower refreshes its own status and looks pedalboards up
+// by bundle in its own banks, so it only needs the same pedalboards as the
+// primary, not the same bank order.
+// this class is thread safe
+class ModHost {
+public:
+    ModHost(std::string hostname);
+    virtual ~ModHost();
+    std::string getHostname();
+    void setSimulate(bool simulate);
+    void setTempoInterval(int msec);
+    void setMaxAge(std::chrono::milliseconds maxAge);
+    // names of the controllers whose commands go to this host, empty for all
+    void setRoutes(std::vector<std::string> routes);
+    // expression pedal values to send, at most rate times a second each
+    void setExpressions(ExpressionMap *expressions, int rate);
+    bool routes(const std::string &controller);
+
+    bool connect(std::chrono::milliseconds timeout);
+    const ConnectTimings &getTimings();
+    // followers get a thread of their own to send commands & check the tempo
+    void start(bool follower);
+    // for simulated sessions, commands & tempo changes are sent straight
+    // away from the caller's thread
+    void startSynchronous();
+    void stop();
+    CommandScheduler &getScheduler();
+
+    // queue a command for a follower
+    void submit(ModCommand command);
+    // the tempo this unit should be at, sent if it changed
+    void setTempo(double bpm);
+    // the tempo the unit is known to be at already, nothing is sent
+    void syncTempo(double bpm);
+private:
+    void followerThreadWork();
+    bool sendTempo(double bpm);
+    bool sendParameter(const std::string &port, double value);
+    bool runCommand(const ModCommand &command);
+    void checkTempo();
+    void refreshStatus();
+    // where this unit keeps a bundle, bank is -1 for its current bank
+    bool findBundle(const std::string &bundle, unsigned int &index, int &bank);
+    std::string hostname;
+    std::vector<std::string> routeList;
+    bool simulate = false;
+    ConnectTimings timings;
+    CommandScheduler scheduler;
+    TempoPublisher tempoPublisher;
+    ParameterPublisher parameterPublisher;
+    ExpressionMap *expressions = NULL;
+    CommandQueue commandQueue;
+    std::thread follower_thread;
+    bool synchronous = false;
+    bool follower_quit = false;
+    // the follower's own bank & pedalboard, only used from its thread
+    std::vector<ModPedalboard> pedalboardList;
+    std::string currentBundle;
+    // protected by m_tempo
+    double targetBPM = 0;
+    std::mutex m_tempo;
+    Counter *metricConnects, *metricCommands, *metricResyncs;
+};
+
+#endif /* MODHOST_H */
+
@@ -0,0 +1,39 @@
+/*
+ * File:   OutputShaper.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "OutputShaper.h"
+
+#include <cmath>
+
+void OutputShaper::setRate(unsigned int bytesPerSecond, jack_nframes_t sampleRate) {
+    framesPerByte = bytesPerSecond > 0 ? (double)sampleRate / bytesPerSecond : 0;
+}
+
+void OutputShaper::endCycle(jack_nframes_t nframes) {
+    busyUntil -= nframes;
+    if (busyUntil < 0) busyUntil = 0;
+}
+
+jack_nframes_t OutputShaper::nextFree(jack_nframes_t earliest) {
+    double free = std::ceil(busyUntil);
+    return free > earliest ? (jack_nframes_t)free : earliest;
+}
+
+bool OutputShaper::fits(jack_nframes_t time, size_t bytes, jack_nframes_t deadline) {
+    if (framesPerByte == 0) return time < deadline;
+    return time + bytes * framesPerByte <= deadline;
+}
+
+void OutputShaper::send(jack_nframes_t time, size_t bytes) {
+    double start = time > busyUntil ? time : busyUntil;
+    busyUntil = start + bytes * framesPerByte;
+}
+
+unsigned int OutputShaper::backlogBytes() {
+    if (framesPerByte == 0) return 0;
+    return (unsigned int)std::ceil(busyUntil / framesPerByte);
+}
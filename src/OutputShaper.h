@@ -0,0 +1,40 @@
+/*
+ * File:   OutputShaper.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef OUTPUTSHAPER_H
+#define OUTPUTSHAPER_H
+
+#include <stddef.h>
+#include <jack/jack.h>
+
+// Models the serial link between ttymidi and the controller (31250 baud, 10
+// bits a byte, so 3125 bytes a second) to know when the link will be free
+// again. Times are frames from the start of the current cycle.
+// only used on the jack realtime thread
+class OutputShaper {
+public:
+    static const unsigned int MIDI_BYTES_PER_SECOND = 3125;
+    // zero bytesPerSecond turns shaping off
+    void setRate(unsigned int bytesPerSecond, jack_nframes_t sampleRate);
+    // move on to the next cycle
+    void endCycle(jack_nframes_t nframes);
+    // first frame at or after earliest when the link is idle
+    jack_nframes_t nextFree(jack_nframes_t earliest);
+    // would bytes sent at time be done by the deadline?
+    bool fits(jack_nframes_t time, size_t bytes, jack_nframes_t deadline);
+    // the link is busy sending bytes from time on
+    void send(jack_nframes_t time, size_t bytes);
+    // bytes still waiting to go out on the link
+    unsigned int backlogBytes();
+private:
+    double framesPerByte = 0;
+    // when the link finishes what it's been given, relative to this cycle
+    double busyUntil = 0;
+};
+
+#endif /* OUTPUTSHAPER_H */
+
@@ -0,0 +1,73 @@
+/*
+ * File:   ParameterPublisher.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "ParameterPublisher.h"
+#include "Log.h"
+#include "Realtime.h"
+
+ParameterPublisher::ParameterPublisher() {
+    MetricsRegistry &m = metrics();
+    metricSent = m.counter("modmidi_parameter_sends_total", "Parameter values sent to the Mod");
+    metricCoalesced = m.counter("modmidi_parameter_coalesced_total", "Parameter values replaced by a newer one before being sent");
+    metricFailed = m.counter("modmidi_parameter_failures_total", "Parameter values the Mod didn't accept");
+    metricLatency = m.histogram("modmidi_parameter_latency_us", "Time from a pedal movement arriving to its value being accepted by the Mod");
+}
+
+ParameterPublisher::~ParameterPublisher() {
+    stop();
+}
+
+void ParameterPublisher::start(ExpressionMap *expressions, std::function<bool(const std::string&, double)> sender) {
+    this->expressions = expressions;
+    this->sender = sender;
+    if (!expressions || expressions->size() == 0) return;
+    publisher_quit = false;
+    publisher_thread = std::thread([=] {threadWork();});
+}
+
+void ParameterPublisher::stop() {
+    publisher_quit = true;
+    if (publisher_thread.joinable()) publisher_thread.join();
+}
+
+void ParameterPublisher::setMaxRate(int perSecond) {
+    if (perSecond <= 0) perSecond = 1;
+    minInterval = std::chrono::microseconds(1000000 / perSecond);
+}
+
+void ParameterPublisher::threadWork() {
+    threadPolicies().apply("parameter");
+    int count = expressions->size();
+    std::vector<uint32_t> lastSequence(count, 0);
+    std::vector<std::chrono::steady_clock::time_point> lastSend(count, std::chrono::steady_clock::time_point());
+    while (!publisher_quit) {
+        for (int i=0; i<count; i++) {
+            double value;
+            std::chrono::steady_clock::time_point changed;
+            uint32_t sequence = expressions->latest(i, value, changed);
+            if (sequence == lastSequence[i]) continue;
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastSend[i] < minInterval) continue;
+            // a failed send is retried at the next interval with the latest
+            // value, so the sequence only moves once it's made it
+            lastSend[i] = now;
+            const std::string &port = expressions->getMapping(i).port;
+            bool ok = sender(port, value);
+            metricSent->inc();
+            if (!ok) {
+                metricFailed->inc();
+                LOG_ERROR("Unable to set %s to %f", port.c_str(), value);
+                continue;
+            }
+            metricCoalesced->inc(sequence - lastSequence[i] - 1);
+            lastSequence[i] = sequence;
+            auto end = std::chrono::steady_clock::now();
+            metricLatency->observe(std::chrono::duration_cast<std::chrono::microseconds>(end - changed).count());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
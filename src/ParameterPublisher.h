@@ -0,0 +1,44 @@
+/*
+ * File:   ParameterPublisher.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef PARAMETERPUBLISHER_H
+#define PARAMETERPUBLISHER_H
+
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "Expression.h"
+#include "Metrics.h"
+
+// Sends expression pedal values to the Mod from its own thread. Each
+// parameter is sent at most maxRate times a second and only its newest value
+// goes out, so a fast sweep turns into a steady trickle of updates.
+// this class is thread safe
+class ParameterPublisher {
+public:
+    ParameterPublisher();
+    virtual ~ParameterPublisher();
+    // sender does the round trip and returns false if it failed
+    void start(ExpressionMap *expressions, std::function<bool(const std::string&, double)> sender);
+    void stop();
+    void setMaxRate(int perSecond);
+private:
+    void threadWork();
+    ExpressionMap *expressions = NULL;
+    std::function<bool(const std::string&, double)> sender;
+    std::thread publisher_thread;
+    bool publisher_quit = false;
+    std::chrono::microseconds minInterval{33333};
+    Counter *metricSent, *metricCoalesced, *metricFailed;
+    Histogram *metricLatency;
+};
+
+#endif /* PARAMETERPUBLISHER_H */
+
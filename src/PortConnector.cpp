@@ -0,0 +1,156 @@
+/*
+ * File:   PortConnector.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "PortConnector.h"
+#include "Log.h"
+#include "Realtime.h"
+
+PortConnector::PortConnector(jack_client_t *client) {
+    this->client = client;
+    metricConnections = metrics().counter("modmidi_port_connections_total", "Jack connections made to the controller ports");
+}
+
+PortConnector::~PortConnector() {
+    stop();
+}
+
+bool PortConnector::addPort(jack_port_t *port, std::string regEx) {
+    Rule rule;
+    rule.port = port;
+    rule.regExString = regEx;
+    try {
+        rule.regEx = std::regex(regEx, std::regex::extended);
+    } catch (std::regex_error &e) {
+        LOG_ERROR("Invalid port regex: %s", regEx.c_str());
+        return false;
+    }
+    rule.isInput = (jack_port_flags(port) & JackPortIsInput) != 0;
+    std::lock_guard<std::mutex> guard(m_wake);
+    rules.push_back(rule);
+    needsCheck = true;
+    return true;
+}
+
+void PortConnector::setCallbacks() {
+    jack_set_port_registration_callback(client, portRegistrationCallback, this);
+    jack_set_port_connect_callback(client, portConnectCallback, this);
+}
+
+void PortConnector::setConnectedCallback(std::function<void(jack_port_t*)> callback) {
+    std::lock_guard<std::mutex> guard(m_wake);
+    connectedCallback = callback;
+}
+
+void PortConnector::start() {
+    {
+        std::lock_guard<std::mutex> guard(m_wake);
+        connector_quit = false;
+        needsCheck = true;
+    }
+    connector_thread = std::thread([=] {threadWork();});
+}
+
+void PortConnector::stop() {
+    {
+        std::lock_guard<std::mutex> guard(m_wake);
+        connector_quit = true;
+    }
+    c_wake.notify_all();
+    if (connector_thread.joinable()) connector_thread.join();
+}
+
+bool PortConnector::allConnected() {
+    std::lock_guard<std::mutex> guard(m_wake);
+    for (auto &rule : rules) {
+        if (!jack_port_connected(rule.port)) return false;
+    }
+    return true;
+}
+
+void PortConnector::wake() {
+    {
+        std::lock_guard<std::mutex> guard(m_wake);
+        needsCheck = true;
+    }
+    c_wake.notify_one();
+}
+
+// called from jack's notification thread
+void PortConnector::portRegistrationCallback(jack_port_id_t port, int reg, void *arg) {
+    PortConnector *self = (PortConnector *)arg;
+    // a port going away shows up as a disconnect, so only new ports matter here
+    if (!reg) return;
+    jack_port_t *p = jack_port_by_id(self->client, port);
+    if (!p || jack_port_is_mine(self->client, p)) return;
+    const char *name = jack_port_name(p);
+    bool matches = false;
+    {
+        std::lock_guard<std::mutex> guard(self->m_wake);
+        for (auto &rule : self->rules) {
+            if (std::regex_search(name, rule.regEx)) matches = true;
+        }
+    }
+    if (matches) self->wake();
+}
+
+// called from jack's notification thread
+void PortConnector::portConnectCallback(jack_port_id_t a, jack_port_id_t b, int connect, void *arg) {
+    PortConnector *self = (PortConnector *)arg;
+    // connections we make ourselves don't need any action
+    if (connect) return;
+    jack_port_t *pa = jack_port_by_id(self->client, a);
+    jack_port_t *pb = jack_port_by_id(self->client, b);
+    if ((pa && jack_port_is_mine(self->client, pa)) || (pb && jack_port_is_mine(self->client, pb))) self->wake();
+}
+
+void PortConnector::threadWork() {
+    threadPolicies().apply("connector");
+    std::unique_lock<std::mutex> lock(m_wake);
+    while (true) {
+        c_wake.wait(lock, [this] {return connector_quit || needsCheck;});
+        if (connector_quit) break;
+        needsCheck = false;
+        lock.unlock();
+        connectAll();
+        lock.lock();
+    }
+}
+
+void PortConnector::connectAll() {
+    std::vector<Rule> currentRules;
+    std::function<void(jack_port_t*)> callback;
+    {
+        std::lock_guard<std::mutex> guard(m_wake);
+        currentRules = rules;
+        callback = connectedCallback;
+    }
+    for (auto &rule : currentRules) {
+        if (jack_port_connected(rule.port)) continue;
+        // look for a port going the other way that matches the rule
+        const char **ports = jack_get_ports(client, NULL, JACK_DEFAULT_MIDI_TYPE, rule.isInput ? JackPortIsOutput : JackPortIsInput);
+        if (!ports) continue;
+        for (int i=0; ports[i]; i++) {
+            if (!std::regex_search(ports[i], rule.regEx)) continue;
+            int retval;
+            if (rule.isInput) {
+                retval = jack_connect(client, ports[i], jack_port_name(rule.port));
+            } else {
+                retval = jack_connect(client, jack_port_name(rule.port), ports[i]);
+            }
+            if (retval == 0) {
+                LOG_INFO("connected %s %s %s", jack_port_name(rule.port), rule.isInput ? "from" : "to", ports[i]);
+                metricConnections->inc();
+                if (callback) callback(rule.port);
+                break;
+            }
+        }
+        jack_free(ports);
+        if (!jack_port_connected(rule.port)) {
+            LOG_INFO("waiting for a port matching %s", rule.regExString.c_str());
+        }
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * File:   PortConnector.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef PORTCONNECTOR_H
+#define PORTCONNECTOR_H
+
+#include <string>
+#include <vector>
+#include <regex>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <jack/jack.h>
+
+#include "Metrics.h"
+
+// Keeps our jack ports connected to the ports matching their regexes. Jack
+// tells us when ports appear, disappear or get disconnected, and a helper
+// thread (jack doesn't allow connecting from inside its callbacks) makes the
+// connections, so ttymidi can start late or restart without us noticing.
+// this class is thread safe
+class PortConnector {
+public:
+    PortConnector(jack_client_t *client);
+    virtual ~PortConnector();
+    // the regex uses the same extended syntax as jack_get_ports()
+    bool addPort(jack_port_t *port, std::string regEx);
+    // must be called before jack_activate()
+    void setCallbacks();
+    // called from the connector thread after one of our ports is connected
+    void setConnectedCallback(std::function<void(jack_port_t*)> callback);
+    void start();
+    void stop();
+    bool allConnected();
+private:
+    class Rule {
+    public:
+        jack_port_t *port;
+        std::string regExString;
+        std::regex regEx;
+        bool isInput;
+    };
+    static void portRegistrationCallback(jack_port_id_t port, int reg, void *arg);
+    static void portConnectCallback(jack_port_id_t a, jack_port_id_t b, int connect, void *arg);
+    void wake();
+    void threadWork();
+    void connectAll();
+    jack_client_t *client;
+    std::vector<Rule> rules;
+    std::function<void(jack_port_t*)> connectedCallback;
+    std::thread connector_thread;
+    std::mutex m_wake;
+    std::condition_variable c_wake;
+    bool needsCheck = true;
+    bool connector_quit = false;
+    Counter *metricConnections;
+};
+
+#endif /* PORTCONNECTOR_H */
+
@@ -0,0 +1,203 @@
+/*
+ * File:   Realtime.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "Realtime.h"
+
+#include <alloca.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Log.h"
+#include "Metrics.h"
+#include "FlightRecorder.h"
+
+static const char *threadNames[] = {"jack", "worker", "status", "tempo", "parameter", "follower", "connector", "metrics", "log"};
+
+static bool parseCpus(std::string spec, uint64_t &cpus) {
+    cpus = 0;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string range = spec.substr(start, end - start);
+        char *rest;
+        long first = strtol(range.c_str(), &rest, 10);
+        long last = first;
+        if (rest == range.c_str()) return false;
+        if (*rest == '-') {
+            const char *lastStart = rest + 1;
+            last = strtol(lastStart, &rest, 10);
+            if (rest == lastStart) return false;
+        }
+        if (*rest != '\0' || first < 0 || last < first || last >= 64) return false;
+        for (long cpu = first; cpu <= last; cpu++) cpus |= (uint64_t)1 << cpu;
+        start = end + 1;
+    }
+    return cpus != 0;
+}
+
+bool ThreadPolicy::parse(std::string spec) {
+    size_t at = spec.find('@');
+    if (at != std::string::npos) {
+        if (!parseCpus(spec.substr(at + 1), cpus)) return false;
+        spec = spec.substr(0, at);
+    }
+    size_t colon = spec.find(':');
+    std::string name = spec.substr(0, colon);
+    if (name == "other") {
+        policy = SCHED_OTHER;
+    } else if (name == "fifo") {
+        policy = SCHED_FIFO;
+    } else if (name == "rr") {
+        policy = SCHED_RR;
+    } else if (name.size() > 0) {
+        return false;
+    }
+    if (colon != std::string::npos) {
+        if (policy < 0) return false;
+        char *end;
+        priority = strtol(spec.c_str() + colon + 1, &end, 10);
+        if (*end != '\0') return false;
+    } else if (policy == SCHED_FIFO || policy == SCHED_RR) {
+        // the bottom of the realtime range, well below jack's
+        priority = 1;
+    }
+    if (policy >= 0 && (priority < sched_get_priority_min(policy) || priority > sched_get_priority_max(policy))) return false;
+    return policy >= 0 || cpus != 0;
+}
+
+bool ThreadPolicies::set(std::string spec) {
+    size_t equals = spec.find('=');
+    if (equals == std::string::npos) return false;
+    std::string name = spec.substr(0, equals);
+    bool known = name == "all";
+    for (auto &n : names()) {
+        if (n == name) known = true;
+    }
+    ThreadPolicy policy;
+    if (!known || !policy.parse(spec.substr(equals + 1))) return false;
+    std::lock_guard<std::mutex> guard(m_policies);
+    policies[name] = policy;
+    return true;
+}
+
+void ThreadPolicies::setPrefault(size_t bytes) {
+    std::lock_guard<std::mutex> guard(m_policies);
+    prefaultBytes = bytes;
+}
+
+// fault in the top of the stack now, so the thread doesn't page later
+static void __attribute__((noinline)) prefaultStack(size_t bytes) {
+    volatile char *stack = (volatile char *)alloca(bytes);
+    long page = sysconf(_SC_PAGESIZE);
+    for (size_t i=0; i<bytes; i += page) {
+        stack[i] = 0;
+    }
+}
+
+static std::string policyName(int policy) {
+    switch(policy) {
+        case SCHED_FIFO:
+            return "fifo";
+        case SCHED_RR:
+            return "rr";
+        case SCHED_OTHER:
+            return "other";
+        default:
+            return std::to_string(policy);
+    }
+}
+
+void ThreadPolicies::apply(std::string name) {
+    size_t bytes;
+    {
+        std::lock_guard<std::mutex> guard(m_policies);
+        bytes = prefaultBytes;
+    }
+    if (bytes > 0) prefaultStack(bytes);
+    // shows up in top -H & ps -L
+    std::string threadName = ("modmidi-" + name).substr(0, 15);
+    pthread_setname_np(pthread_self(), threadName.c_str());
+    flightRecorder().nameThread(name.c_str());
+    apply(name, pthread_self());
+}
+
+void ThreadPolicies::apply(std::string name, pthread_t thread) {
+    ThreadPolicy policy;
+    {
+        std::lock_guard<std::mutex> guard(m_policies);
+        auto found = policies.find(name);
+        if (found == policies.end() && name != "jack") found = policies.find("all");
+        if (found != policies.end()) policy = found->second;
+    }
+    if (policy.policy >= 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = policy.priority;
+        int error = pthread_setschedparam(thread, policy.policy, &param);
+        if (error) LOG_WARN("Unable to set %s scheduling for the %s thread: %s", policyName(policy.policy).c_str(), name.c_str(), strerror(error));
+    }
+    if (policy.cpus) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu=0; cpu<64; cpu++) {
+            if (policy.cpus & ((uint64_t)1 << cpu)) CPU_SET(cpu, &set);
+        }
+        int error = pthread_setaffinity_np(thread, sizeof(set), &set);
+        if (error) LOG_WARN("Unable to set the CPUs for the %s thread: %s", name.c_str(), strerror(error));
+    }
+    // report what the thread ended up with, whether we changed it or not
+    int effectivePolicy;
+    struct sched_param param;
+    if (pthread_getschedparam(thread, &effectivePolicy, &param) != 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    uint64_t cpus = 0;
+    std::string cpuList;
+    if (pthread_getaffinity_np(thread, sizeof(set), &set) == 0) {
+        for (int cpu=0; cpu<64; cpu++) {
+            if (!CPU_ISSET(cpu, &set)) continue;
+            cpus |= (uint64_t)1 << cpu;
+            if (cpuList.size() > 0) cpuList += ",";
+            cpuList += std::to_string(cpu);
+        }
+    }
+    LOG_INFO("%s thread: %s priority %d, cpus %s", name.c_str(), policyName(effectivePolicy).c_str(), param.sched_priority, cpuList.c_str());
+    std::string labels = "thread=\"" + name + "\"";
+    metrics().gauge("modmidi_thread_priority", "Realtime priority of each thread, 0 if it isn't realtime", labels)->set(param.sched_priority);
+    metrics().gauge("modmidi_thread_cpus", "Bitmask of the CPUs each thread may run on", labels)->set(cpus);
+}
+
+std::vector<std::string> ThreadPolicies::names() {
+    return std::vector<std::string>(threadNames, threadNames + sizeof(threadNames) / sizeof(threadNames[0]));
+}
+
+ThreadPolicies &threadPolicies() {
+    static ThreadPolicies policies;
+    return policies;
+}
+
+bool lockMemory() {
+    int result = -1;
+#ifdef MCL_ONFAULT
+    // pages are locked as they're touched, otherwise every thread's whole
+    // stack gets locked in as soon as it starts
+    result = mlockall(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT);
+#endif
+    // older kernels don't know MCL_ONFAULT
+    if (result != 0) result = mlockall(MCL_CURRENT | MCL_FUTURE);
+    if (result != 0) {
+        LOG_WARN("Unable to lock memory: %s", strerror(errno));
+        return false;
+    }
+    LOG_INFO("Memory locked");
+    metrics().gauge("modmidi_memory_locked", "1 if ModMidi's memory is locked so it can't page")->set(1);
+    return true;
+}
@@ -0,0 +1,60 @@
+/*
+ * File:   Realtime.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <map>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+// how one of ModMidi's threads should be scheduled
+class ThreadPolicy {
+public:
+    // parses [other|fifo|rr][:PRIORITY][@CPUS], CPUS like 0 or 0,2-3
+    bool parse(std::string spec);
+    // SCHED_OTHER, SCHED_FIFO or SCHED_RR, -1 to leave it alone
+    int policy = -1;
+    int priority = 0;
+    // bit i is set to run on cpu i, 0 to leave the affinity alone
+    uint64_t cpus = 0;
+};
+
+// The scheduling, affinity & stack prefaulting for each named thread. Threads
+// call apply() as they start, which also logs what they actually got.
+// this class is thread safe
+class ThreadPolicies {
+public:
+    // parses NAME=POLICY, NAME "all" covers every ModMidi thread that isn't
+    // named itself (but not jack's)
+    bool set(std::string spec);
+    static const size_t PREFAULT_BYTES = 128 * 1024;
+    // touch this much of each thread's stack up front, 0 for none
+    void setPrefault(size_t bytes);
+    // call from the thread itself
+    void apply(std::string name);
+    // for a thread that isn't ours, e.g. jack's process thread
+    void apply(std::string name, pthread_t thread);
+    static std::vector<std::string> names();
+private:
+    std::mutex m_policies;
+    std::map<std::string, ThreadPolicy> policies;
+    size_t prefaultBytes = 0;
+};
+
+ThreadPolicies &threadPolicies();
+
+// lock all of ModMidi's memory so it never pages, returns false if the
+// system won't allow it (needs root or a big enough memlock limit)
+bool lockMemory();
+
+#endif /* REALTIME_H */
+
@@ -0,0 +1,44 @@
+/*
+ * File:   RunningStatus.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "RunningStatus.h"
+
+#include <string.h>
+
+void RunningStatusEncoder::setEnabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+void RunningStatusEncoder::setResyncInterval(uint64_t frames) {
+    resyncInterval = frames;
+}
+
+void RunningStatusEncoder::requestResync() {
+    resyncRequested.store(true, std::memory_order_relaxed);
+}
+
+size_t RunningStatusEncoder::encode(const unsigned char *in, size_t size, unsigned char *out, uint64_t frame) {
+    memcpy(out, in, size);
+    if (!enabled || size == 0) return size;
+    if (resyncRequested.exchange(false, std::memory_order_relaxed)) runningStatus = 0;
+    unsigned char status = in[0];
+    // realtime messages can go anywhere and don't affect running status
+    if (status >= 0xF8) return size;
+    // sysex & system common messages cancel it
+    if (status >= 0xF0 || status < 0x80) {
+        runningStatus = 0;
+        return size;
+    }
+    bool resync = resyncInterval > 0 && frame - lastFullStatus >= resyncInterval;
+    if (status == runningStatus && !resync) {
+        memmove(out, out + 1, size - 1);
+        return size - 1;
+    }
+    runningStatus = status;
+    lastFullStatus = frame;
+    return size;
+}
@@ -0,0 +1,44 @@
+/*
+ * File:   RunningStatus.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef RUNNINGSTATUS_H
+#define RUNNINGSTATUS_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Drops the status byte of a channel message when it's the same as the last
+// one sent (MIDI running status), so a run of LED CCs costs 2 bytes each
+// instead of 3. The full status is sent again every resync interval, and
+// after anything that cancels running status, for receivers that lose track.
+// Jack ports are meant to carry complete messages, so the shortened ones only
+// make sense when ModMidi is the only writer into a raw serial bridge (e.g.
+// ttymidi). ModMidi doesn't own the serial link, so jack is the closest it
+// can get to the wire.
+// only used on the jack realtime thread, except requestResync()
+class RunningStatusEncoder {
+public:
+    void setEnabled(bool enabled);
+    // in frames, 0 never resyncs
+    void setResyncInterval(uint64_t frames);
+    // send the full status with the next message, thread safe
+    void requestResync();
+    // frame is an absolute frame count, returns the number of bytes written
+    // to out, which needs room for size bytes
+    size_t encode(const unsigned char *in, size_t size, unsigned char *out, uint64_t frame);
+private:
+    bool enabled = false;
+    uint64_t resyncInterval = 0;
+    // 0 when there's no running status
+    unsigned char runningStatus = 0;
+    uint64_t lastFullStatus = 0;
+    std::atomic<bool> resyncRequested{false};
+};
+
+#endif /* RUNNINGSTATUS_H */
+
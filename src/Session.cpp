@@ -0,0 +1,184 @@
+/*
+ * File:   Session.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "Session.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#include "Clock.h"
+#include "DeviceProfile.h"
+#include "Log.h"
+#include "Worker.h"
+
+// simulated jack settings, 240 frames makes a cycle exactly 5ms
+static const jack_nframes_t SESSION_SAMPLE_RATE = 48000;
+static const jack_nframes_t SESSION_CYCLE_FRAMES = 240;
+static const int SESSION_CYCLE_USEC = 5000;
+
+static bool byTime(const SessionStep &a, const SessionStep &b) {
+    return a.msec < b.msec;
+}
+
+bool Session::load(std::string filename) {
+    std::ifstream in(filename);
+    if (!in) {
+        LOG_ERROR("Unable to open session %s", filename.c_str());
+        return false;
+    }
+    this->filename = filename;
+    steps.clear();
+    endMsec = 0;
+    std::string text;
+    int line = 0;
+    while (std::getline(in, text)) {
+        line++;
+        size_t comment = text.find('#');
+        if (comment != std::string::npos) text.erase(comment);
+        if (text.find_first_not_of(" \t\r") == std::string::npos) continue;
+        SessionStep step;
+        step.line = line;
+        char action[16] = "", what[16] = "";
+        int msec;
+        double value;
+        if (sscanf(text.c_str(), " at %d %15s", &msec, action) != 2 || msec < 0) {
+            LOG_ERROR("%s:%d: expected \"at MSEC ...\"", filename.c_str(), line);
+            return false;
+        }
+        step.msec = msec;
+        if (strcmp(action, "press") == 0 && sscanf(text.c_str(), " at %*d %*s %lf", &value) == 1) {
+            step.type = SessionStep::PRESS;
+        } else if (strcmp(action, "release") == 0 && sscanf(text.c_str(), " at %*d %*s %lf", &value) == 1) {
+            step.type = SessionStep::RELEASE;
+        } else if (strcmp(action, "expect") == 0 && sscanf(text.c_str(), " at %*d %*s %15s %lf", what, &value) == 2) {
+            if (strcmp(what, "pedalboard") == 0) {
+                step.type = SessionStep::EXPECT_PEDALBOARD;
+            } else if (strcmp(what, "preset") == 0) {
+                step.type = SessionStep::EXPECT_PRESET;
+            } else if (strcmp(what, "bpm") == 0) {
+                step.type = SessionStep::EXPECT_BPM;
+            } else {
+                LOG_ERROR("%s:%d: can't expect \"%s\"", filename.c_str(), line, what);
+                return false;
+            }
+        } else {
+            LOG_ERROR("%s:%d: unknown step \"%s\"", filename.c_str(), line, action);
+            return false;
+        }
+        step.value = value;
+        steps.push_back(step);
+        endMsec = std::max(endMsec, msec);
+    }
+    std::stable_sort(steps.begin(), steps.end(), byTime);
+    return true;
+}
+
+void Session::setJitter(int msec) {
+    jitter = msec > 0 ? msec : 0;
+}
+
+int Session::run(unsigned int seed) {
+    // jitter the presses, the expectations stay where they were written
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> offset(-jitter, jitter);
+    std::vector<SessionStep> script = steps;
+    // the last offset of each switch, so a release can't come before its press
+    int offsets[128] = {};
+    for (auto &step : script) {
+        if (jitter == 0 || step.value < 0 || step.value > 127) continue;
+        if (step.type == SessionStep::PRESS) offsets[(int)step.value] = offset(random);
+        if (step.type == SessionStep::PRESS || step.type == SessionStep::RELEASE) step.msec = std::max(0, step.msec + offsets[(int)step.value]);
+    }
+    std::stable_sort(script.begin(), script.end(), byTime);
+
+    // presses are CC104 values & releases CC105, the way an FCB1010 sends them
+    DeviceProfile profile;
+    DeviceProfile::find("fcb1010", profile);
+    VirtualClock clock;
+    setCurrentClock(&clock);
+    int failures = 0;
+    {
+        Worker worker(NULL);
+        worker.addController("session", NULL, NULL, profile);
+        worker.setSimulate(true);
+        worker.startSimulation();
+        size_t next = 0;
+        // every tick is one jack cycle, running whenever the worker waits
+        clock.setTick(std::chrono::microseconds(SESSION_CYCLE_USEC), [&] {
+            long long now = clock.elapsed().count();
+            long long cycleStart = now - SESSION_CYCLE_USEC;
+            while (next < script.size() && (long long)script[next].msec * 1000 <= now) {
+                const SessionStep &step = script[next++];
+                if (step.type == SessionStep::PRESS || step.type == SessionStep::RELEASE) {
+                    MidiEvent e;
+                    e.eventType = MidiEvent::CC;
+                    e.data1 = step.type == SessionStep::PRESS ? 104 : 105;
+                    e.data2 = (unsigned char)step.value;
+                    ControlEvent control;
+                    if (!profile.decode(e, control)) {
+                        LOG_ERROR("%s:%d: %d isn't a switch", filename.c_str(), step.line, (int)step.value);
+                        failures++;
+                        continue;
+                    }
+                    long long frame = ((long long)step.msec * 1000 - cycleStart) * SESSION_SAMPLE_RATE / 1000000;
+                    control.time = (jack_nframes_t)std::max(0LL, std::min(frame, (long long)SESSION_CYCLE_FRAMES - 1));
+                    control.controller = 0;
+                    worker.switchInput(control, SESSION_CYCLE_FRAMES);
+                    continue;
+                }
+                int pedalboard, preset;
+                double bpm;
+                worker.getState(pedalboard, preset, bpm);
+                bool passed;
+                double actual;
+                if (step.type == SessionStep::EXPECT_PEDALBOARD) {
+                    actual = pedalboard;
+                    passed = pedalboard == (int)step.value;
+                } else if (step.type == SessionStep::EXPECT_PRESET) {
+                    actual = preset;
+                    passed = preset == (int)step.value;
+                } else {
+                    actual = bpm;
+                    passed = std::fabs(bpm - step.value) < 0.5;
+                }
+                if (!passed) {
+                    LOG_ERROR("%s:%d: expected %g at %d ms, got %g (seed %u)", filename.c_str(), step.line, step.value, step.msec, actual, seed);
+                    failures++;
+                }
+            }
+            worker.jackProcess(SESSION_CYCLE_FRAMES);
+        });
+        // the worker & status threads' loops, taking turns
+        while (next < script.size()) {
+            worker.workerStep();
+            worker.statusStep();
+            clock.sleepFor(std::chrono::milliseconds(1));
+        }
+        clock.setTick(std::chrono::microseconds(0), nullptr);
+        worker.stop();
+    }
+    setCurrentClock(NULL);
+    return failures;
+}
+
+bool Session::runAll(int count, unsigned int seed) {
+    auto started = std::chrono::steady_clock::now();
+    int failed = 0, failures = 0;
+    for (int i=0; i<count; i++) {
+        int result = run(seed + i);
+        if (result > 0) failed++;
+        failures += result;
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    double simulated = (double)count * endMsec / 1000.0;
+    LOG_INFO("%d sessions, %d failed (%d expectations), %.1f s simulated in %.3f s", count, failed, failures, simulated, wall);
+    return failed == 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * File:   Session.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <string>
+#include <vector>
+
+// One line of a session script, e.g.
+//   at 0 press 6
+//   at 100 release 6
+//   at 1500 expect pedalboard 0
+class SessionStep {
+public:
+    enum Type {
+        PRESS,
+        RELEASE,
+        EXPECT_PEDALBOARD,
+        EXPECT_PRESET,
+        EXPECT_BPM
+    };
+    Type type = PRESS;
+    int msec = 0;
+    double value = 0;
+    int line = 0;
+};
+
+// Plays a scripted session against a simulated worker on virtual time. There's
+// no jack server & no threads: the session drives the jack cycles, the worker
+// loop and the status updates itself, so every run with the same seed does
+// exactly the same thing, and a minute of pedalling takes milliseconds.
+class Session {
+public:
+    bool load(std::string filename);
+    // presses are moved by up to +/- msec, different for every run, and
+    // releases move with their press
+    void setJitter(int msec);
+    // runs the script once on a fresh worker, returns the failed expectations
+    int run(unsigned int seed);
+    // runs it count times with seeds starting at seed, returns false if any
+    // expectation failed
+    bool runAll(int count, unsigned int seed);
+private:
+    std::vector<SessionStep> steps;
+    std::string filename;
+    int jitter = 0;
+    int endMsec = 0;
+};
+
+#endif /* SESSION_H */
+
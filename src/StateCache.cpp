@@ -0,0 +1,126 @@
+/*
+ * File:   StateCache.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "StateCache.h"
+#include "Log.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static void copyString(char *dest, const std::string &src, size_t size) {
+    strncpy(dest, src.c_str(), size - 1);
+    dest[size - 1] = 0;
+}
+
+static std::string readString(const char *src, size_t size) {
+    return std::string(src, strnlen(src, size));
+}
+
+StateCache::StateCache() {
+}
+
+StateCache::~StateCache() {
+    close();
+}
+
+bool StateCache::open(std::string filename) {
+    std::lock_guard<std::mutex> guard(m_data);
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        LOG_WARN("Unable to open state cache %s", filename.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (st.st_size != sizeof(Data) && ftruncate(fd, sizeof(Data)) < 0)) {
+        LOG_WARN("Unable to size state cache %s", filename.c_str());
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    void *p = mmap(NULL, sizeof(Data), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        LOG_WARN("Unable to map state cache %s", filename.c_str());
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    data = (Data *)p;
+    return true;
+}
+
+void StateCache::close() {
+    std::lock_guard<std::mutex> guard(m_data);
+    if (data) munmap(data, sizeof(Data));
+    if (fd >= 0) ::close(fd);
+    data = NULL;
+    fd = -1;
+}
+
+bool StateCache::load(std::vector<ModPedalboard> &pedalboardList, std::vector<std::string> &presetList, int &currentPedalboard, int &currentPreset, unsigned int &pedalboardOffset, double &bpm) {
+    std::lock_guard<std::mutex> guard(m_data);
+    if (!data) return false;
+    if (data->magic != MAGIC || data->version != VERSION || data->size != sizeof(Data) || (data->sequence & 1)) return false;
+    if (data->pedalboardCount > MAX_PEDALBOARDS || data->presetCount > MAX_PRESETS) return false;
+    if (data->currentPedalboard >= (int32_t)data->pedalboardCount || data->currentPreset >= (int32_t)data->presetCount) return false;
+    pedalboardList.clear();
+    for (uint32_t i=0; i<data->pedalboardCount; i++) {
+        ModPedalboard p;
+        p.title = readString(data->pedalboards[i].title, TITLE_SIZE);
+        p.bundle = readString(data->pedalboards[i].bundle, BUNDLE_SIZE);
+        pedalboardList.push_back(p);
+    }
+    presetList.clear();
+    for (uint32_t i=0; i<data->presetCount; i++) {
+        presetList.push_back(readString(data->presets[i], TITLE_SIZE));
+    }
+    currentPedalboard = data->currentPedalboard;
+    currentPreset = data->currentPreset;
+    pedalboardOffset = data->pedalboardOffset < data->pedalboardCount ? data->pedalboardOffset : 0;
+    bpm = currentPedalboard >= 0 ? data->pedalboards[currentPedalboard].bpm : 0;
+    return true;
+}
+
+void StateCache::save(const std::vector<ModPedalboard> &pedalboardList, const std::vector<std::string> &presetList, int currentPedalboard, int currentPreset, unsigned int pedalboardOffset, double bpm) {
+    std::lock_guard<std::mutex> guard(m_data);
+    if (!data) return;
+    // don't bother caching banks that don't fit
+    if (pedalboardList.size() > MAX_PEDALBOARDS || presetList.size() > MAX_PRESETS) return;
+    // the pedalboard can be from another bank for a moment, e.g. right after
+    // a load or a failed status update
+    if (currentPedalboard >= (int)pedalboardList.size()) currentPedalboard = -1;
+    bool valid = data->magic == MAGIC && data->version == VERSION && data->size == sizeof(Data) && !(data->sequence & 1);
+    // keep the remembered tempos if the bank hasn't changed
+    bool sameBank = valid && data->pedalboardCount == pedalboardList.size();
+    for (size_t i=0; sameBank && i<pedalboardList.size(); i++) {
+        if (readString(data->pedalboards[i].bundle, BUNDLE_SIZE) != pedalboardList[i].bundle) sameBank = false;
+    }
+    data->sequence = valid ? data->sequence + 1 : 1;
+    __sync_synchronize();
+    data->magic = MAGIC;
+    data->version = VERSION;
+    data->size = sizeof(Data);
+    data->currentPedalboard = currentPedalboard;
+    data->currentPreset = currentPreset;
+    data->pedalboardOffset = pedalboardOffset;
+    data->pedalboardCount = pedalboardList.size();
+    data->presetCount = presetList.size();
+    for (size_t i=0; i<pedalboardList.size(); i++) {
+        Pedalboard &p = data->pedalboards[i];
+        copyString(p.title, pedalboardList[i].title, TITLE_SIZE);
+        copyString(p.bundle, pedalboardList[i].bundle, BUNDLE_SIZE);
+        if (!sameBank) p.bpm = 0;
+    }
+    for (size_t i=0; i<presetList.size(); i++) {
+        copyString(data->presets[i], presetList[i], TITLE_SIZE);
+    }
+    if (currentPedalboard >= 0 && currentPedalboard < (int)pedalboardList.size() && bpm > 0) data->pedalboards[currentPedalboard].bpm = bpm;
+    __sync_synchronize();
+    data->sequence++;
+}
@@ -0,0 +1,68 @@
+/*
+ * File:   StateCache.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef STATECACHE_H
+#define STATECACHE_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+
+#include "Utilities.h"
+
+// Remembers the last known Mod state in a small memory mapped file, so after a
+// restart the lights & tempo can be shown right away while the first status
+// update is still running.
+// this class is thread safe
+class StateCache {
+public:
+    static const uint32_t MAGIC = 0x4d4d5343;
+    // bump this whenever the layout below changes
+    static const uint32_t VERSION = 1;
+    static const int MAX_PEDALBOARDS = 128;
+    static const int MAX_PRESETS = 32;
+    static const int TITLE_SIZE = 64;
+    static const int BUNDLE_SIZE = 192;
+
+    StateCache();
+    virtual ~StateCache();
+    bool open(std::string filename);
+    void close();
+    // returns false if nothing valid is cached
+    bool load(std::vector<ModPedalboard> &pedalboardList, std::vector<std::string> &presetList, int &currentPedalboard, int &currentPreset, unsigned int &pedalboardOffset, double &bpm);
+    void save(const std::vector<ModPedalboard> &pedalboardList, const std::vector<std::string> &presetList, int currentPedalboard, int currentPreset, unsigned int pedalboardOffset, double bpm);
+private:
+    class Pedalboard {
+    public:
+        char title[TITLE_SIZE];
+        char bundle[BUNDLE_SIZE];
+        // the last tempo seen for this pedalboard, 0 if unknown
+        double bpm;
+    };
+    class Data {
+    public:
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;
+        // odd while a write is in progress
+        uint32_t sequence;
+        int32_t currentPedalboard;
+        int32_t currentPreset;
+        uint32_t pedalboardOffset;
+        uint32_t pedalboardCount;
+        uint32_t presetCount;
+        Pedalboard pedalboards[MAX_PEDALBOARDS];
+        char presets[MAX_PRESETS][TITLE_SIZE];
+    };
+    std::mutex m_data;
+    Data *data = NULL;
+    int fd = -1;
+};
+
+#endif /* STATECACHE_H */
+
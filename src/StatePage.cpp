@@ -0,0 +1,88 @@
+/*
+ * File:   StatePage.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "StatePage.h"
+#include "Log.h"
+
+#include <sys/stat.h>
+
+StatePage::StatePage() {
+}
+
+StatePage::~StatePage() {
+    close();
+}
+
+bool StatePage::open(std::string name) {
+    std::lock_guard<std::mutex> guard(m_data);
+    // the page outlives ModMidi, so readers carry on across a restart
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        LOG_WARN("Unable to open state page %s", name.c_str());
+        return false;
+    }
+    if (ftruncate(fd, sizeof(StatePageData)) < 0) {
+        LOG_WARN("Unable to size state page %s", name.c_str());
+        ::close(fd);
+        return false;
+    }
+    void *p = mmap(NULL, sizeof(StatePageData), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        LOG_WARN("Unable to map state page %s", name.c_str());
+        return false;
+    }
+    data = (StatePageData *)p;
+    // keep counting from where the last run left off, an odd sequence means
+    // it died while writing
+    uint32_t sequence = data->sequence.load(std::memory_order_relaxed);
+    data->sequence.store(sequence | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    data->magic = StatePageData::MAGIC;
+    data->version = StatePageData::VERSION;
+    data->size = sizeof(StatePageData);
+    data->running = 1;
+    data->updateTime = statePageNow();
+    data->sequence.store((sequence | 1) + 1, std::memory_order_release);
+    return true;
+}
+
+void StatePage::close() {
+    std::lock_guard<std::mutex> guard(m_data);
+    if (!data) return;
+    uint32_t sequence = data->sequence.load(std::memory_order_relaxed);
+    data->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    data->running = 0;
+    data->updateTime = statePageNow();
+    data->sequence.store(sequence + 2, std::memory_order_release);
+    munmap(data, sizeof(StatePageData));
+    data = NULL;
+}
+
+bool StatePage::isOpen() {
+    std::lock_guard<std::mutex> guard(m_data);
+    return data != NULL;
+}
+
+StatePageData *StatePage::begin() {
+    m_data.lock();
+    if (!data) {
+        m_data.unlock();
+        return NULL;
+    }
+    uint32_t sequence = data->sequence.load(std::memory_order_relaxed);
+    data->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return data;
+}
+
+void StatePage::end() {
+    data->updateTime = statePageNow();
+    data->sequence.store(data->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    m_data.unlock();
+}
@@ -0,0 +1,129 @@
+/*
+ * File:   StatePage.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef STATEPAGE_H
+#define STATEPAGE_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ModMidi publishes what it knows about the Mod in a POSIX shared memory page
+// (/modmidi by default), so other programs on the same machine, e.g. a setlist
+// display, don't have to poll mod-ui themselves. The page is guarded by a
+// seqlock: ModMidi never waits for readers, and reading is just a copy with
+// no syscalls. This header has everything a reader needs, see
+// tools/StateMonitor.cpp for an example.
+
+class StatePageData {
+public:
+    static const uint32_t MAGIC = 0x4d4d5350;
+    // bump this whenever the layout below changes
+    static const uint32_t VERSION = 1;
+    static const int TITLE_SIZE = 64;
+    // the pedalboards on the 5 switches
+    static const int SWITCHES = 5;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    // odd while a write is in progress
+    std::atomic<uint32_t> sequence;
+    // 0 once ModMidi has exited
+    uint32_t running;
+    // number of Mods ModMidi is driving
+    uint32_t hosts;
+    // 1 if the last status update got everything from the Mod
+    uint32_t statusOk;
+    int32_t pedalboard;
+    int32_t preset;
+    uint32_t pedalboardOffset;
+    uint32_t pedalboardCount;
+    uint32_t presetCount;
+    double bpm;
+    // CLOCK_MONOTONIC nsec of the start of a beat, 0 if the tempo is paused
+    uint64_t beatTime;
+    // CLOCK_MONOTONIC nsec of the last status update & the last write
+    uint64_t statusTime;
+    uint64_t updateTime;
+    char pedalboardTitle[TITLE_SIZE];
+    char presetTitle[TITLE_SIZE];
+    char switchTitles[SWITCHES][TITLE_SIZE];
+};
+
+inline uint64_t statePageNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// map a page for reading, returns NULL if ModMidi hasn't created and sized it
+inline const StatePageData *statePageOpen(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+    // ModMidi may not have sized it yet (or it's not ours), reading past the
+    // end of the object would be a SIGBUS
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(StatePageData)) {
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, sizeof(StatePageData), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    return (const StatePageData *)p;
+}
+
+// take a consistent copy of the page, returns false if it isn't valid, or if
+// no consistent copy turned up in tries attempts (e.g. ModMidi was killed in
+// the middle of a write), back off & try again later then
+inline bool statePageRead(const StatePageData *page, StatePageData &snapshot, int tries = 100000) {
+    while (true) {
+        if (tries-- <= 0) return false;
+        uint32_t before = page->sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        memcpy((void *)&snapshot, (const void *)page, sizeof(StatePageData));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page->sequence.load(std::memory_order_relaxed) == before) break;
+    }
+    return snapshot.magic == StatePageData::MAGIC && snapshot.version == StatePageData::VERSION && snapshot.size == sizeof(StatePageData);
+}
+
+// where we are in the current beat, 0-1, or -1 if there's no tempo
+inline double statePageBeatPhase(const StatePageData &snapshot, uint64_t now) {
+    if (snapshot.beatTime == 0 || snapshot.bpm <= 0 || now < snapshot.beatTime) return -1;
+    double beats = (double)(now - snapshot.beatTime) / 1e9 * snapshot.bpm / 60.0;
+    return beats - (double)(uint64_t)beats;
+}
+
+// ModMidi's side
+// this class is thread safe
+class StatePage {
+public:
+    StatePage();
+    virtual ~StatePage();
+    bool open(std::string name);
+    void close();
+    bool isOpen();
+    // fill in the page between begin() & end(), readers retry if they see
+    // a write in progress
+    StatePageData *begin();
+    void end();
+private:
+    std::mutex m_data;
+    StatePageData *data = NULL;
+};
+
+#endif /* STATEPAGE_H */
+
@@ -0,0 +1,83 @@
+/*
+ * File:   TempoPublisher.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#include "TempoPublisher.h"
+#include "Log.h"
+#include "Realtime.h"
+
+TempoPublisher::TempoPublisher() {
+    MetricsRegistry &m = metrics();
+    metricSent = m.counter("modmidi_tempo_sends_total", "set_bpm commands sent to the Mod");
+    metricSuppressed = m.counter("modmidi_tempo_suppressed_total", "Tempo changes replaced by a newer one before they were sent");
+    metricFailed = m.counter("modmidi_tempo_failures_total", "set_bpm commands that failed");
+    metricDelay = m.histogram("modmidi_tempo_publish_delay_us", "Time from a tempo change to its set_bpm completing");
+}
+
+TempoPublisher::~TempoPublisher() {
+    stop();
+}
+
+void TempoPublisher::start(std::function<bool(double)> sender) {
+    this->sender = sender;
+    {
+        std::lock_guard<std::mutex> guard(m_pending);
+        publisher_quit = false;
+    }
+    publisher_thread = std::thread([=] {threadWork();});
+}
+
+void TempoPublisher::stop() {
+    {
+        std::lock_guard<std::mutex> guard(m_pending);
+        publisher_quit = true;
+    }
+    c_pending.notify_all();
+    if (publisher_thread.joinable()) publisher_thread.join();
+}
+
+void TempoPublisher::setMinInterval(int msec) {
+    std::lock_guard<std::mutex> guard(m_pending);
+    minInterval = std::chrono::milliseconds(msec);
+}
+
+void TempoPublisher::publish(double bpm) {
+    {
+        std::lock_guard<std::mutex> guard(m_pending);
+        if (hasPending) metricSuppressed->inc();
+        hasPending = true;
+        pendingBPM = bpm;
+    }
+    c_pending.notify_one();
+}
+
+void TempoPublisher::threadWork() {
+    threadPolicies().apply("tempo");
+    auto lastSend = std::chrono::steady_clock::now() - std::chrono::hours(1);
+    auto firstPublished = lastSend;
+    std::unique_lock<std::mutex> lock(m_pending);
+    while (true) {
+        c_pending.wait(lock, [this] {return publisher_quit || hasPending;});
+        if (publisher_quit) break;
+        firstPublished = std::chrono::steady_clock::now();
+        // keep collecting newer values until the minimum interval has passed
+        c_pending.wait_until(lock, lastSend + minInterval, [this] {return publisher_quit;});
+        if (publisher_quit) break;
+        double bpm = pendingBPM;
+        hasPending = false;
+        lastSend = std::chrono::steady_clock::now();
+        lock.unlock();
+        bool ok = sender(bpm);
+        auto end = std::chrono::steady_clock::now();
+        metricSent->inc();
+        if (!ok) {
+            metricFailed->inc();
+            LOG_ERROR("Unable to send new tempo %f", bpm);
+        }
+        metricDelay->observe(std::chrono::duration_cast<std::chrono::microseconds>(end - firstPublished).count());
+        lock.lock();
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * File:   TempoPublisher.h
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ */
+
+#ifndef TEMPOPUBLISHER_H
+#define TEMPOPUBLISHER_H
+
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+
+#include "Metrics.h"
+
+// Sends tap tempo changes to the Mod from its own thread. Only the newest BPM
+// is kept, at most one set_bpm is in flight, and sends are spaced at least
+// minInterval apart. Values replaced before they were sent are counted as
+// suppressed.
+// this class is thread safe
+class TempoPublisher {
+public:
+    TempoPublisher();
+    virtual ~TempoPublisher();
+    // sender does the actual round trip and returns false if it failed
+    void start(std::function<bool(double)> sender);
+    void stop();
+    void setMinInterval(int msec);
+    // never blocks
+    void publish(double bpm);
+private:
+    void threadWork();
+    std::function<bool(double)> sender;
+    std::thread publisher_thread;
+    std::mutex m_pending;
+    std::condition_variable c_pending;
+    bool publisher_quit = false;
+    bool hasPending = false;
+    double pendingBPM = 0;
+    std::chrono::milliseconds minInterval{100};
+    Counter *metricSent, *metricSuppressed, *metricFailed;
+    Histogram *metricDelay;
+};
+
+#endif /* TEMPOPUBLISHER_H */
+
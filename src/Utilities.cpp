@@ -6,8 +6,8 @@
  */
 
 #include <string>
+#include <cstdlib>
 #include <iomanip>
-#include <iostream>
 #include <sstream>
 #include <vector>
 #include <jansson.h>
@@ -19,6 +19,9 @@
 #include <condition_variable>
 
 #include "Utilities.h"
+#include "Metrics.h"
+#include "Log.h"
+#include "FlightRecorder.h"
 
 void findAndReplaceAll(std::string &data, std::string toSearch, std::string replaceStr) {
     size_t pos = data.find(toSearch);
@@ -45,16 +48,55 @@ void waitForQuit() {
     c_quitFlag.wait(lock, []{return quitFlag;});
 }
 
+class CommandMetrics {
+public:
+    std::string command;
+    Histogram *duration;
+    Counter *errors;
+};
+
+// look up the metrics for a command without taking a lock, the table is
+// built once on first use
+static CommandMetrics *commandMetrics(const std::string &command) {
+    static std::vector<CommandMetrics> table = [] {
+        std::vector<CommandMetrics> t;
+        for (auto name : {"get_bank", "get_presets", "get_pedalboard", "get_bpm", "set_bpm", "set_parameter", "load_preset", "load_pedalboard", "other"}) {
+            CommandMetrics m;
+            m.command = name;
+            std::string labels = "command=\"" + m.command + "\"";
+            m.duration = metrics().histogram("modmidi_command_duration_us", "Round trip time of commands sent to the Mod", labels);
+            m.errors = metrics().counter("modmidi_command_errors_total", "Commands that failed to get a response from the Mod", labels);
+            t.push_back(m);
+        }
+        return t;
+    }();
+    for (auto &m : table) {
+        if (m.command == command) return &m;
+    }
+    return &table.back();
+}
+
+// holds the caller's mutex (if there is one) until the end of the scope
+static std::unique_lock<std::mutex> lockIfGiven(std::mutex *mutex) {
+    return mutex ? std::unique_lock<std::mutex>(*mutex) : std::unique_lock<std::mutex>();
+}
+
 bool sendMessage(int socket, std::mutex *mutex, std::string command, std::string data, std::string &response) {
+    static Counter *disconnects = metrics().counter("modmidi_mod_disconnects_total", "Times the connection to the Mod was lost");
+    CommandMetrics *cm = commandMetrics(command);
     std::lock_guard<std::mutex> guard(*mutex);
     auto start = std::chrono::steady_clock::now();
+    flightRecorder().record(FlightRecorder::BEGIN, command.c_str(), data.length());
     std::string message = command;
     if (data.length() > 0) message += " " + data;
     message += "\n";
     if (send(socket, message.c_str(), message.length(), 0) < 0) {
-        std::cout << "sendMessage: send failed" << std::endl;
+        LOG_ERROR("sendMessage: send failed");
+        cm->errors->inc();
+        disconnects->inc();
         // this probably means we disconnected from the server, and a restart is in order
         signalQuit();
+        flightRecorder().record(FlightRecorder::END, command.c_str());
         return false;
     }
     
@@ -70,9 +112,12 @@ bool sendMessage(int socket, std::mutex *mutex, std::string command, std::string
     while ((ret = poll(&fd, 1, 10000)) > 0) {
         bytes = recv(socket, server_reply, sizeof(server_reply), 0);
         if (bytes <= 0) {
-            std::cout << "sendMessage: error while receiving from server" << std::endl;
+            LOG_ERROR("sendMessage: error while receiving from server");
+            cm->errors->inc();
+            disconnects->inc();
             // this probably means we disconnected from the server, and a restart is in order
             signalQuit();
+            flightRecorder().record(FlightRecorder::END, command.c_str());
             return false;
         }
         std::string chunk(server_reply, bytes);
@@ -85,9 +130,12 @@ bool sendMessage(int socket, std::mutex *mutex, std::string command, std::string
         }
     }
     if (ret <= 0) {
-        std::cout << "sendMessage: error while receiving data from server" << std::endl;
+        LOG_ERROR("sendMessage: error while receiving data from server");
+        cm->errors->inc();
+        disconnects->inc();
         // this probably means we disconnected from the server, and a restart is in order
         signalQuit();
+        flightRecorder().record(FlightRecorder::END, command.c_str());
         return false;
     }
     
@@ -95,66 +143,69 @@ bool sendMessage(int socket, std::mutex *mutex, std::string command, std::string
     findAndReplaceAll(return_data, "\\n", "\n");
     
     response = return_data;
+    flightRecorder().record(FlightRecorder::END, command.c_str(), response.size(), 1);
     auto end = std::chrono::steady_clock::now();
-    auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-    std::cout << "sendMessage: " << command << " took " << diff.count() << " msec" << std::endl;
+    auto diff = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    cm->duration->observe(diff.count());
+    LOG_DEBUG("sendMessage: %s took %ld usec", command.c_str(), (long)diff.count());
     return true;
 }
 
-bool getPedalboardList(int socket, std::mutex *socket_mutex, std::vector<ModPedalboard> &pedalboardList, std::mutex *mutex) {
+bool getPedalboardList(int socket, std::mutex *socket_mutex, std::vector<ModPedalboard> &pedalboardList, std::mutex *mutex, int bank) {
     std::string response;
     bool status;
     
-    // get the current bank
-    status = sendMessage(socket, socket_mutex, "get_bank", "", response);
+    // get the current bank, or the one asked for
+    std::string data = bank >= 0 ? "{\"id\": " + std::to_string(bank) + "}" : "";
+    status = sendMessage(socket, socket_mutex, "get_bank", data, response);
     if (!status) {
-        std::cout << "getPedalboardList error" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPedalboardList error");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         pedalboardList.clear();
         return false;
     }
     json_error_t err;
     json_t *root = json_loads(response.c_str(), JSON_DECODE_ANY, &err);
     if (!root) {
-        std::cout << "getPedalboardList: unable to parse JSON" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPedalboardList: unable to parse JSON");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         pedalboardList.clear();
         return false;
     }
     if (!json_is_object(root)) {
-        std::cout << "getPedalboardList: JSON root is not object" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPedalboardList: JSON root is not object");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         pedalboardList.clear();
         json_decref(root);
         return false;
     }
     json_t *okay = json_object_get(root, "okay");
     if (!okay || !json_is_boolean(okay) || !json_boolean_value(okay)) {
-        std::cout << "getPedalboardList: not okay" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPedalboardList: not okay");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         pedalboardList.clear();
         json_decref(root);
         return false;
     }
-    json_t *bank = json_object_get(root, "bank");
-    if (!bank || !json_is_object(bank)) {
-        std::cout << "getPedalboardList: bank not found" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+    json_t *json_bank = json_object_get(root, "bank");
+    if (!json_bank || !json_is_object(json_bank)) {
+        LOG_ERROR("getPedalboardList: bank not found");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         pedalboardList.clear();
         json_decref(root);
         return false;
     }
-    json_t *pedalboards = json_object_get(bank, "pedalboards");
+    json_t *pedalboards = json_object_get(json_bank, "pedalboards");
     if (!pedalboards) {
-        std::cout << "getPedalboardList: no pedalboards array" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPedalboardList: no pedalboards array");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         pedalboardList.clear();
         json_decref(root);
         return false;
     }
     if (!json_is_array(pedalboards)) {
-        std::cout << "getPedalboardList: pedalboards is not an array" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPedalboardList: pedalboards is not an array");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         pedalboardList.clear();
         json_decref(root);
         return false;
@@ -164,8 +215,8 @@ bool getPedalboardList(int socket, std::mutex *socket_mutex, std::vector<ModPeda
     for (size_t i=0; i<json_array_size(pedalboards); i++) {
         json_t *data = json_array_get(pedalboards, i);
         if (!json_is_object(data)) {
-            std::cout << "getPedalboardList: pedalboard is not an object" << std::endl;
-            if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+            LOG_ERROR("getPedalboardList: pedalboard is not an object");
+            std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
             pedalboardList.clear();
             json_decref(root);
             return false;
@@ -174,15 +225,15 @@ bool getPedalboardList(int socket, std::mutex *socket_mutex, std::vector<ModPeda
         title = json_object_get(data, "title");
         bundle = json_object_get(data, "bundle");
         if (!title || !bundle) {
-            std::cout << "getPedalboardList: could not find title & bundle in pedalboard" << std::endl;
-            if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+            LOG_ERROR("getPedalboardList: could not find title & bundle in pedalboard");
+            std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
             pedalboardList.clear();
             json_decref(root);
             return false;
         }
         if (!json_is_string(title) || !json_is_string(bundle)) {
-            std::cout << "getPedalboardList: title & bundle aren't strings" << std::endl;
-            if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+            LOG_ERROR("getPedalboardList: title & bundle aren't strings");
+            std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
             pedalboardList.clear();
             json_decref(root);
             return false;
@@ -192,12 +243,69 @@ bool getPedalboardList(int socket, std::mutex *socket_mutex, std::vector<ModPeda
         mb.bundle = json_string_value(bundle);
         tempPedalboardList.push_back(mb);
     }
-    if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+    std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
     pedalboardList = tempPedalboardList;
     json_decref(root);
     return true;
 }
 
+bool getBankList(int socket, std::mutex *socket_mutex, std::vector<ModBank> &bankList, int &currentBank) {
+    std::string response;
+    bool status;
+    
+    // get every bank, without their pedalboards
+    status = sendMessage(socket, socket_mutex, "get_banks", "", response);
+    if (!status) {
+        LOG_ERROR("getBankList error");
+        return false;
+    }
+    json_error_t err;
+    json_t *root = json_loads(response.c_str(), JSON_DECODE_ANY, &err);
+    if (!root) {
+        LOG_ERROR("getBankList: unable to parse JSON");
+        return false;
+    }
+    if (!json_is_object(root)) {
+        LOG_ERROR("getBankList: root is not an object");
+        json_decref(root);
+        return false;
+    }
+    json_t *okay = json_object_get(root, "okay");
+    if (!okay || !json_is_boolean(okay) || !json_boolean_value(okay)) {
+        LOG_ERROR("getBankList: not okay");
+        json_decref(root);
+        return false;
+    }
+    json_t *banks = json_object_get(root, "banks");
+    json_t *current = json_object_get(root, "current");
+    if (!banks || !json_is_array(banks) || !current || !json_is_integer(current)) {
+        LOG_ERROR("getBankList: unable to find the correct data");
+        json_decref(root);
+        return false;
+    }
+    std::vector<ModBank> tempBankList;
+    for (size_t i=0; i<json_array_size(banks); i++) {
+        json_t *data = json_array_get(banks, i);
+        json_t *id = json_object_get(data, "id");
+        json_t *title = json_object_get(data, "title");
+        json_t *count = json_object_get(data, "count");
+        if (!id || !title || !count || !json_is_integer(id) || !json_is_string(title) || !json_is_integer(count)) {
+            LOG_ERROR("getBankList: bank doesn't have an id, title & count");
+            json_decref(root);
+            return false;
+        }
+        ModBank mb;
+        mb.id = json_integer_value(id);
+        mb.title = json_string_value(title);
+        mb.count = json_integer_value(count);
+        tempBankList.push_back(mb);
+    }
+    bankList = tempBankList;
+    currentBank = json_integer_value(current);
+    json_decref(root);
+    return true;
+}
+
 bool getPresetList(int socket, std::mutex *socket_mutex, std::vector<std::string> &presetList, std::mutex *mutex) {
     std::string response;
     bool status;
@@ -205,45 +313,45 @@ bool getPresetList(int socket, std::mutex *socket_mutex, std::vector<std::string
     // get the pedalboard preset list
     status = sendMessage(socket, socket_mutex, "get_presets", "", response);
     if (!status) {
-        std::cout << "getPresetList error" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPresetList error");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         presetList.clear();
         return false;
     }
     json_error_t err;
     json_t *root = json_loads(response.c_str(), JSON_DECODE_ANY, &err);
     if (!root) {
-        std::cout << "getPresetList: unable to parse JSON" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPresetList: unable to parse JSON");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         presetList.clear();
         return false;
     }
     if (!json_is_object(root)) {
-        std::cout << "getPresetList: JSON root is not object" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPresetList: JSON root is not object");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         presetList.clear();
         json_decref(root);
         return false;
     }
     json_t *okay = json_object_get(root, "okay");
     if (!okay || !json_is_boolean(okay) || !json_boolean_value(okay)) {
-        std::cout << "getPresetList: not okay" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPresetList: not okay");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         presetList.clear();
         json_decref(root);
         return false;
     }
     json_t *presets = json_object_get(root, "presets");
     if (!presets || !json_is_object(presets)) {
-        std::cout << "getPresetList: presets not found" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getPresetList: presets not found");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         presetList.clear();
         json_decref(root);
         return false;
     }
     
     // look for the pedalboard presets one by one
-    if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+    std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
     presetList.clear();
     for (int i=0; i<999; i++) {
         json_t *preset = json_object_get(presets, std::to_string(i).c_str());
@@ -262,38 +370,38 @@ bool getCurrentPedalboardAndPreset(int socket, std::mutex *socket_mutex, std::ve
     // get the pedalboard preset list
     status = sendMessage(socket, socket_mutex, "get_pedalboard", "", response);
     if (!status) {
-        std::cout << "getCurrentPedalboardAndPreset error" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getCurrentPedalboardAndPreset error");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         currentPedalboard = currentPreset = -1;
         return false;
     }
     json_error_t err;
     json_t *root = json_loads(response.c_str(), JSON_DECODE_ANY, &err);
     if (!root) {
-        std::cout << "getCurrentPedalboardAndPreset: unable to parse JSON" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getCurrentPedalboardAndPreset: unable to parse JSON");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         currentPedalboard = currentPreset = -1;
         return false;
     }
     if (!json_is_object(root)) {
-        std::cout << "getCurrentPedalboardAndPreset: root is not an object" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getCurrentPedalboardAndPreset: root is not an object");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         currentPedalboard = currentPreset = -1;
         json_decref(root);
         return false;
     }
     json_t *okay = json_object_get(root, "okay");
     if (!okay || !json_is_boolean(okay) || !json_boolean_value(okay)) {
-        std::cout << "getCurrentPedalboardAndPreset: not okay" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getCurrentPedalboardAndPreset: not okay");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         currentPedalboard = currentPreset = -1;
         json_decref(root);
         return false;
     }
     json_t *pedalboard = json_object_get(root, "pedalboard");
     if (!pedalboard || !json_is_object(pedalboard)) {
-        std::cout << "getCurrentPedalboardAndPreset: pedalboard not found" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getCurrentPedalboardAndPreset: pedalboard not found");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         currentPedalboard = currentPreset = -1;
         json_decref(root);
         return false;
@@ -301,13 +409,13 @@ bool getCurrentPedalboardAndPreset(int socket, std::mutex *socket_mutex, std::ve
     json_t *json_path = json_object_get(pedalboard, "path");
     json_t *json_preset = json_object_get(pedalboard, "preset");
     if (!json_path || !json_preset || !json_is_string(json_path) || !json_is_integer(json_preset)) {
-        std::cout << "getCurrentPedalboardAndPreset: unable to find the correct data" << std::endl;
-        if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+        LOG_ERROR("getCurrentPedalboardAndPreset: unable to find the correct data");
+        std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
         currentPedalboard = currentPreset = -1;
         json_decref(root);
         return false;
     }
-    if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+    std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
     std::string path = json_string_value(json_path);
     currentPedalboard = -1;
     for (size_t i=0; i<pedalboardList.size(); i++) {
@@ -336,33 +444,33 @@ bool getCurrentBPM(int socket, std::mutex *socket_mutex, double &currentBPM, std
     // get the pedalboard preset list
     status = sendMessage(socket, socket_mutex, "get_bpm", "", response);
     if (!status) {
-        std::cout << "getCurrentBPM error" << std::endl;
+        LOG_ERROR("getCurrentBPM error");
         return false;
     }
     json_error_t err;
     json_t *root = json_loads(response.c_str(), JSON_DECODE_ANY | JSON_DECODE_INT_AS_REAL, &err);
     if (!root) {
-        std::cout << "getCurrentBPM: unable to parse JSON" << std::endl;
+        LOG_ERROR("getCurrentBPM: unable to parse JSON");
         return false;
     }
     if (!json_is_object(root)) {
-        std::cout << "getCurrentBPM: root is not an object" << std::endl;
+        LOG_ERROR("getCurrentBPM: root is not an object");
         json_decref(root);
         return false;
     }
     json_t *okay = json_object_get(root, "okay");
     if (!okay || !json_is_boolean(okay) || !json_boolean_value(okay)) {
-        std::cout << "getCurrentBPM: not okay" << std::endl;
+        LOG_ERROR("getCurrentBPM: not okay");
         json_decref(root);
         return false;
     }
     json_t *bpm = json_object_get(root, "bpm");
     if (!bpm || !json_is_number(bpm)) {
-        std::cout << "getCurrentBPM: bpm does not exist or is not a number" << std::endl;
+        LOG_ERROR("getCurrentBPM: bpm does not exist or is not a number");
         json_decref(root);
         return false;
     }
-    if (mutex) std::lock_guard<std::mutex> guard(*mutex);
+    std::unique_lock<std::mutex> guard = lockIfGiven(mutex);
     currentBPM = json_number_value(bpm);
     json_decref(root);
     return true;
@@ -375,23 +483,63 @@ bool setBPM(int socket, std::mutex *socket_mutex, double bpm) {
     // get the pedalboard preset list
     status = sendMessage(socket, socket_mutex, "set_bpm", "{\"bpm\": " + std::to_string(bpm) + "}", response);
     if (!status) {
-        std::cout << "setBPM error" << std::endl;
+        LOG_ERROR("setBPM error");
+        return false;
+    }
+    json_error_t err;
+    json_t *root = json_loads(response.c_str(), JSON_DECODE_ANY, &err);
+    if (!root) {
+        LOG_ERROR("setBPM: unable to parse JSON");
+        return false;
+    }
+    if (!json_is_object(root)) {
+        LOG_ERROR("setBPM: root is not an object");
+        json_decref(root);
+        return false;
+    }
+    json_t *okay = json_object_get(root, "okay");
+    if (!okay || !json_is_boolean(okay) || !json_boolean_value(okay)) {
+        LOG_ERROR("setBPM: not okay");
+        json_decref(root);
+        return false;
+    }
+    json_decref(root);
+    return true;
+}
+
+bool setParameter(int socket, std::mutex *socket_mutex, std::string port, double value) {
+    std::string response;
+    bool status;
+    
+    // the port comes from the command line, let jansson escape it
+    json_t *request = json_pack("{s:s, s:f}", "port", port.c_str(), "value", value);
+    char *payload = request ? json_dumps(request, 0) : NULL;
+    json_decref(request);
+    if (!payload) {
+        LOG_ERROR("setParameter: unable to encode port %s", port.c_str());
+        return false;
+    }
+    std::string message(payload);
+    free(payload);
+    status = sendMessage(socket, socket_mutex, "set_parameter", message, response);
+    if (!status) {
+        LOG_ERROR("setParameter error");
         return false;
     }
     json_error_t err;
     json_t *root = json_loads(response.c_str(), JSON_DECODE_ANY, &err);
     if (!root) {
-        std::cout << "setBPM: unable to parse JSON" << std::endl;
+        LOG_ERROR("setParameter: unable to parse JSON");
         return false;
     }
     if (!json_is_object(root)) {
-        std::cout << "setBPM: root is not an object" << std::endl;
+        LOG_ERROR("setParameter: root is not an object");
         json_decref(root);
         return false;
     }
     json_t *okay = json_object_get(root, "okay");
     if (!okay || !json_is_boolean(okay) || !json_boolean_value(okay)) {
-        std::cout << "setBPM: not okay" << std::endl;
+        LOG_ERROR("setParameter: not okay");
         json_decref(root);
         return false;
     }
@@ -406,23 +554,23 @@ bool loadPreset(int socket, std::mutex *socket_mutex, int preset) {
     // get the pedalboard preset list
     status = sendMessage(socket, socket_mutex, "load_preset", "{\"id\": " + std::to_string(preset) + "}", response);
     if (!status) {
-        std::cout << "loadPreset error" << std::endl;
+        LOG_ERROR("loadPreset error");
         return false;
     }
     json_error_t err;
     json_t *root = json_loads(response.c_str(), JSON_DECODE_ANY, &err);
     if (!root) {
-        std::cout << "loadPreset: unable to parse JSON" << std::endl;
+        LOG_ERROR("loadPreset: unable to parse JSON");
         return false;
     }
     if (!json_is_object(root)) {
-        std::cout << "loadPreset: root is not an object" << std::endl;
+        LOG_ERROR("loadPreset: root is not an object");
         json_decref(root);
         return false;
     }
     json_t *okay = json_object_get(root, "okay");
     if (!okay || !json_is_boolean(okay) || !json_boolean_value(okay)) {
-        std::cout << "loadPreset: not okay" << std::endl;
+        LOG_ERROR("loadPreset: not okay");
         json_decref(root);
         return false;
     }
@@ -430,30 +578,32 @@ bool loadPreset(int socket, std::mutex *socket_mutex, int preset) {
     return true;
 }
 
-bool loadPedalboard(int socket, std::mutex *socket_mutex, int pedalboard) {
+bool loadPedalboard(int socket, std::mutex *socket_mutex, int pedalboard, int bank) {
     std::string response;
     bool status;
     
     // get the pedalboard preset list
-    status = sendMessage(socket, socket_mutex, "load_pedalboard", "{\"id\": " + std::to_string(pedalboard) + "}", response);
+    std::string data = "{\"id\": " + std::to_string(pedalboard) + "}";
+    if (bank >= 0) data = "{\"bank\": " + std::to_string(bank) + ", \"id\": " + std::to_string(pedalboard) + "}";
+    status = sendMessage(socket, socket_mutex, "load_pedalboard", data, response);
     if (!status) {
-        std::cout << "loadPedalboard error" << std::endl;
+        LOG_ERROR("loadPedalboard error");
         return false;
     }
     json_error_t err;
     json_t *root = json_loads(response.c_str(), JSON_DECODE_ANY, &err);
     if (!root) {
-        std::cout << "loadPedalboard: unable to parse JSON" << std::endl;
+        LOG_ERROR("loadPedalboard: unable to parse JSON");
         return false;
     }
     if (!json_is_object(root)) {
-        std::cout << "loadPedalboard: root is not an object" << std::endl;
+        LOG_ERROR("loadPedalboard: root is not an object");
         json_decref(root);
         return false;
     }
     json_t *okay = json_object_get(root, "okay");
     if (!okay || !json_is_boolean(okay) || !json_boolean_value(okay)) {
-        std::cout << "loadPedalboard: not okay" << std::endl;
+        LOG_ERROR("loadPedalboard: not okay");
         json_decref(root);
         return false;
     }
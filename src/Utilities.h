@@ -17,13 +17,24 @@ public:
     std::string bundle;
 };
 
+class ModBank {
+public:
+    int id;
+    std::string title;
+    // number of pedalboards the Mod says the bank has
+    unsigned int count;
+};
+
 void signalQuit();
 
 void waitForQuit();
 
 bool sendMessage(int socket, std::mutex *mutex, std::string command, std::string data, std::string &response);
 
-bool getPedalboardList(int socket, std::mutex *socket_mutex, std::vector<ModPedalboard> &pedalboardList, std::mutex *mutex);
+// the pedalboards in the current bank, or in another one if bank >= 0
+bool getPedalboardList(int socket, std::mutex *socket_mutex, std::vector<ModPedalboard> &pedalboardList, std::mutex *mutex, int bank = -1);
+
+bool getBankList(int socket, std::mutex *socket_mutex, std::vector<ModBank> &bankList, int &currentBank);
 
 bool getPresetList(int socket, std::mutex *socket_mutex, std::vector<std::string> &presetList, std::mutex *mutex);
 
@@ -33,9 +44,12 @@ bool getCurrentBPM(int socket, std::mutex *socket_mutex, double &currentBPM, std
 
 bool setBPM(int socket, std::mutex *socket_mutex, double bpm);
 
+bool setParameter(int socket, std::mutex *socket_mutex, std::string port, double value);
+
 bool loadPreset(int socket, std::mutex *socket_mutex, int preset);
 
-bool loadPedalboard(int socket, std::mutex *socket_mutex, int pedalboard);
+// bank >= 0 loads a pedalboard from another bank, which then becomes current
+bool loadPedalboard(int socket, std::mutex *socket_mutex, int pedalboard, int bank = -1);
 
 #endif /* UTILITIES_H */
 
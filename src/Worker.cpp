@@ -7,16 +7,17 @@
 
 #include "Worker.h"
 
-#include <iostream>
+#include "Log.h"
+#include "Clock.h"
+#include "Realtime.h"
+#include "FlightRecorder.h"
+
 #include <string.h>
 #include <jansson.h>
 
 #include <jack/midiport.h>
 #include <valarray>
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <netdb.h>
-#include <arpa/inet.h>
+#include <algorithm>
 #include <unistd.h>
 
 #include <time.h>
@@ -35,71 +36,139 @@ void Worker::setTempoLight(bool tempoLight) {
     tempoLightEnabled = tempoLight;
 }
 
-Worker::Worker(jack_client_t *client, jack_port_t *inputPort, jack_port_t *outputPort) {
+void Worker::setTempoInterval(int msec) {
+    tempoInterval = msec;
+}
+
+void Worker::setDeviceLatency(int msec) {
+    deviceLatency = msec > 0 ? (jack_nframes_t)((int64_t)sampleRate * msec / 1000) : 0;
+    updateTempoLead();
+}
+
+void Worker::updateLatency(jack_latency_callback_mode_t mode) {
+    for (auto &c : controllers) {
+        c->updateLatency(mode);
+    }
+    updateTempoLead();
+}
+
+void Worker::updateTempoLead() {
+    // every controller flashes on the same schedule, so go by the slowest
+    jack_nframes_t roundTrip = 0;
+    for (auto &c : controllers) {
+        roundTrip = std::max(roundTrip, c->getRoundTripLatency());
+    }
+    jack_nframes_t lead = roundTrip + deviceLatency;
+    if (tempoLead.exchange(lead) != lead) {
+        LOG_INFO("Tempo light leads the beat by %.1f ms", lead * 1000.0 / sampleRate);
+    }
+    metricTempoLead->set(lead);
+}
+
+Worker::Worker(jack_client_t *client) {
     this->client = client;
-    this->inputPort = inputPort;
-    this->outputPort = outputPort;
     
-    sampleRate = jack_get_sample_rate(client);
+    // there's no client when running a simulated session
+    sampleRate = client ? jack_get_sample_rate(client) : 48000;
+    
+    MetricsRegistry &m = metrics();
+    metricMidiIn = m.counter("modmidi_midi_in_events_total", "MIDI events received from the controller");
+    metricMidiOut = m.counter("modmidi_midi_out_events_total", "MIDI events sent to the controller");
+    metricLEDMessages = m.counter("modmidi_led_messages_total", "LED & display messages sent to the controller");
+    metricTaps = m.counter("modmidi_taps_total", "Tap tempo presses");
+    metricConnects = m.counter("modmidi_mod_connects_total", "Successful connections to the Mods");
+    metricStatusUpdates = m.counter("modmidi_status_updates_total", "Status refreshes from the Mod");
+    metricPedalboardLoads = m.counter("modmidi_pedalboard_loads_total", "Pedalboard loads sent to the Mod");
+    metricPresetLoads = m.counter("modmidi_preset_loads_total", "Preset loads sent to the Mod");
+    metricTempoLead = m.gauge("modmidi_tempo_light_lead_frames", "How early the tempo light is sent to make up for latency");
 }
 
 Worker::~Worker() {
     stop();
 }
 
+void Worker::addController(std::string name, jack_port_t *inputPort, jack_port_t *outputPort, const DeviceProfile &profile) {
+    controllers.emplace_back(new Controller(name, inputPort, outputPort, profile));
+}
+
+void Worker::addHost(std::string hostname, std::vector<std::string> routes) {
+    hosts.emplace_back(new ModHost(hostname));
+    hosts.back()->setRoutes(routes);
+}
+
+void Worker::addExpression(const ExpressionMapping &mapping) {
+    if (!expressions.add(mapping)) LOG_WARN("Too many expression mappings, ignoring CC%d", mapping.cc);
+}
+
+void Worker::setExpressionSmoothing(int msec) {
+    expressions.setSmoothing(msec);
+}
+
+void Worker::setExpressionRate(int perSecond) {
+    expressionRate = perSecond;
+}
+
+void Worker::setThru(const ThruFilter &filter, unsigned int budget) {
+    for (auto &c : controllers) {
+        c->setThru(filter, budget);
+    }
+}
+
+void Worker::setLinkRate(unsigned int bytesPerSecond) {
+    for (auto &c : controllers) {
+        c->setLinkRate(bytesPerSecond, sampleRate);
+    }
+}
+
+void Worker::setRunningStatus(bool enabled, int resyncMsec) {
+    for (auto &c : controllers) {
+        c->setRunningStatus(enabled, resyncMsec, sampleRate);
+    }
+}
+
+void Worker::setGestureTimes(const GestureTimes &times) {
+    for (auto &c : controllers) {
+        c->getGestures().setTimes(times, sampleRate);
+    }
+}
+
 bool Worker::start() {
-    // create socket
-    modSocket1 = socket(AF_INET, SOCK_STREAM, 0);
-    if (modSocket1 == -1) {
-        std::cout << "Could not create socket 1" << std::endl;
-        return false;
+    if (hosts.size() == 0) addHost("localhost", std::vector<std::string>());
+    // connect to every host at once so extra units don't slow down startup
+    std::vector<std::thread> connectThreads;
+    std::vector<char> connected(hosts.size(), false);
+    for (size_t i=0; i<hosts.size(); i++) {
+        hosts[i]->setSimulate(simulate);
+        hosts[i]->setTempoInterval(tempoInterval);
+        hosts[i]->setMaxAge(maxAge);
+        hosts[i]->setExpressions(&expressions, expressionRate);
+        connectThreads.push_back(std::thread([this, i, &connected] {connected[i] = hosts[i]->connect(connectTimeout);}));
     }
-    modSocket2 = socket(AF_INET, SOCK_STREAM, 0);
-    if (modSocket2 == -1) {
-        std::cout << "Could not create socket 2" << std::endl;
-        close(modSocket1);
-        return false;
+    for (auto &t : connectThreads) {
+        t.join();
     }
-    // get the IP address from our hostname
-    addrinfo hints, *infoptr;
-    memset(&hints, 0, sizeof hints);
-    hints.ai_family = AF_INET;
-    int result = getaddrinfo(hostname.c_str(), NULL, &hints, &infoptr);
-    if (result) {
-        std::cout << "Unable to get IP address for hostname: " << gai_strerror(result) << std::endl;
-        close(modSocket1);
-        close(modSocket2);
+    if (!connected[0]) {
+        LOG_ERROR("Unable to connect to Mod Duo");
         return false;
     }
-    bool connected = false;
-    struct addrinfo *p;
-    char host[256];
-    for (p = infoptr; p != NULL; p = p->ai_next) {
-        getnameinfo(p->ai_addr, p->ai_addrlen, host, sizeof(host), NULL, 0, NI_NUMERICHOST);
-        // try to connect to each IP address until we get one that works
-        struct sockaddr_in server;
-        server.sin_addr.s_addr = inet_addr(host);
-        server.sin_family = AF_INET;
-        server.sin_port = htons(7777);
-        if (connect(modSocket1, (struct sockaddr *) &server, sizeof(server)) >= 0) {
-            if (connect(modSocket2, (struct sockaddr *) &server, sizeof(server)) < 0) {
-                std::cout << "Unable to connect socket 2" << std::endl;
-                close(modSocket1);
-                return false;
-            }
-            std::cout << "Connected to Mod Duo using IP address " << host << std::endl;
-            connected = true;
-            break;
-        }
+    for (size_t i=0; i<hosts.size(); i++) {
+        if (connected[i]) metricConnects->inc();
     }
-    freeaddrinfo(infoptr);
-    if (!connected) {
-        std::cout << "Unable to connect to Mod Duo" << std::endl;
-        close(modSocket1);
-        close(modSocket2);
-        return false;
+    const ConnectTimings &timings = hosts[0]->getTimings();
+    metrics().gauge("modmidi_startup_dns_ms", "Time taken to look up the Mod's address")->set(timings.dnsMsec);
+    metrics().gauge("modmidi_startup_connect_ms", "Time taken to connect to the Mod, including the lookup")->set(timings.totalMsec);
+    // a missing follower shouldn't stop the primary from being used
+    for (size_t i=hosts.size(); i-- > 1; ) {
+        if (!connected[i]) {
+            LOG_WARN("Continuing without Mod Duo %s", hosts[i]->getHostname().c_str());
+            hosts.erase(hosts.begin() + i);
+        }
     }
+    scheduler = &hosts[0]->getScheduler();
 
+    for (size_t i=0; i<hosts.size(); i++) {
+        hosts[i]->start(i > 0);
+    }
     worker_quit = false;
     worker_thread = std::thread([=] {threadWork();});
     status_update_thread = std::thread([=] {statusUpdateThreadWork();});
@@ -107,149 +176,499 @@ bool Worker::start() {
     return true;
 }
 
+bool Worker::startSimulation() {
+    simulate = true;
+    if (hosts.size() == 0) addHost("localhost", std::vector<std::string>());
+    for (auto &host : hosts) {
+        host->setSimulate(true);
+        host->setMaxAge(maxAge);
+        host->startSynchronous();
+    }
+    scheduler = &hosts[0]->getScheduler();
+    return true;
+}
+
+// called from the jack realtime thread, or a simulated session
+void Worker::switchInput(ControlEvent e, jack_nframes_t nframes) {
+    ControlEvent gestures[2];
+    int count = controllers[e.controller]->getGestures().input(e, cycleStart + e.time, gestures);
+    for (int i=0; i<count; i++) {
+        injectControl(gestures[i], nframes);
+    }
+}
+
+// called from the jack realtime thread, or a simulated session
+void Worker::injectControl(ControlEvent e, jack_nframes_t nframes) {
+    // deal with tap tempo events directly
+    if (e.action == ControlEvent::TAP_TEMPO) {
+        metricTaps->inc();
+        tapTempoTap(e.time, nframes);
+    } else {
+        // drops the oldest press if the worker has fallen behind
+        controlEvents.push(e);
+    }
+}
+
+void Worker::getState(int &pedalboard, int &preset, double &bpm) {
+    {
+        std::lock_guard<std::mutex> guard(m_status);
+        pedalboard = currentPedalboard;
+        preset = currentPreset;
+    }
+    std::lock_guard<std::mutex> guard(m_tapTempo);
+    bpm = tapTempoBPM;
+}
+
 void Worker::stop() {
     worker_quit = true;
     if (worker_thread.joinable()) worker_thread.join();
     if (status_update_thread.joinable()) status_update_thread.join();
+    for (auto &host : hosts) {
+        host->stop();
+    }
 }
 
 // called on the jack realtime thread
-bool Worker::midiInput(void* port_buf, jack_nframes_t nframes) {
-    jack_midi_event_t in_event;
-    jack_nframes_t event_count = jack_midi_get_event_count(port_buf);
+bool Worker::midiInput(jack_nframes_t nframes) {
+    jack_nframes_t event_count = 0;
+    for (auto &c : controllers) {
+        event_count += c->beginCycle(nframes);
+    }
     if (event_count == 0) return true;
 
-    std::unique_lock<std::mutex> lock(m_midiInputEvents);
-    for (jack_nframes_t i=0; i<event_count; i++) {
-        jack_midi_event_get(&in_event, port_buf, i);
-        // filter out tap tempo button events & deal with them directly
-        MidiEvent e(in_event);
-        if (e.eventType == MidiEvent::CC && e.data1 == 104 && e.data2 == 11) {
-            tapTempoTap(e.time, nframes);
-        } else {
-            midiInputEvents.push_back(e);
+    metricMidiIn->inc(event_count);
+    // merge the controllers' events in time order, each port's events are
+    // already sorted so this is just a walk over all of them
+    while (true) {
+        int next = -1;
+        jack_nframes_t nextTime = nframes;
+        for (size_t i=0; i<controllers.size(); i++) {
+            jack_nframes_t t = controllers[i]->nextInputTime();
+            if (t < nextTime) {
+                nextTime = t;
+                next = i;
+            }
+        }
+        if (next < 0) break;
+        ControlEvent e;
+        MidiEvent raw;
+        if (!controllers[next]->readInput(e, raw)) continue;
+        if (e.action == ControlEvent::NONE) {
+            // maybe an expression pedal
+            expressions.input(raw);
+            continue;
         }
+        e.controller = next;
+        switchInput(e, nframes);
     }
     return true;
 }
 
 // called on the jack realtime thread
-bool Worker::midiOutput(void* port_buf, jack_nframes_t nframes) {
-    std::unique_lock<std::mutex> lock(m_midiOutputEvents);
-    
-    jack_midi_clear_buffer(port_buf);
-    
-    while(midiOutputEvents.size() > 0) {
-        MidiEvent e = midiOutputEvents.front();
-        midiOutputEvents.pop_front();
-        std::vector<unsigned char> buf = e.getBuffer();
-        if (buf.size()) {
-            unsigned char* buffer = jack_midi_event_reserve(port_buf, e.time, buf.size());
-            for (size_t i=0; i<buf.size(); i++) {
-                buffer[i] = buf.at(i);
-            }
-        }
+bool Worker::midiOutput(jack_nframes_t nframes) {
+    for (auto &c : controllers) {
+        metricMidiOut->inc(c->writeOutput(nframes));
     }
     return true;
 }
 
 void Worker::statusUpdateThreadWork() {
-    // variable used in the status update thread loop
-    bool needsStatusUpdate;
-    // start the loop
+    threadPolicies().apply("status");
     while(!worker_quit) {
-        // do we need a status update?
-        {
-            std::lock_guard<std::mutex> guard(m_nextStatusUpdate);
-            needsStatusUpdate = nextStatusUpdate == 0;
-        }
-        if (needsStatusUpdate) statusUpdate();
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        statusStep();
+        currentClock().sleepFor(std::chrono::seconds(1));
+    }
+    LOG_INFO("Status update thread exiting");
+}
+
+void Worker::statusStep() {
+    // do we need a status update?
+    bool needsStatusUpdate;
+    {
+        std::lock_guard<std::mutex> guard(m_nextStatusUpdate);
+        needsStatusUpdate = nextStatusUpdate == 0;
+    }
+    refreshCatalog();
+    if (!needsStatusUpdate) return;
+    // this waits for any footswitch commands to finish first
+    scheduler->acquire(CommandScheduler::BACKGROUND);
+    bool finished = statusUpdate(CommandScheduler::BACKGROUND);
+    scheduler->release(CommandScheduler::BACKGROUND);
+    if (!finished) {
+        // interrupted by a footswitch command, try again soon
+        std::lock_guard<std::mutex> guard(m_nextStatusUpdate);
+        nextStatusUpdate = sampleRate;
     }
-    cout << "Status update thread exiting" << endl;
 }
 
 void Worker::threadWork() {
-    // variables used in the worker loop
-    bool hasNewTempo;
-    double newTempo;
-    // start the loop
+    threadPolicies().apply("worker");
     while(!worker_quit) {
-        // do midi events need to be processed?
-        processMidi();
-        // do we need to send the Mod the new tempo?
-        {
-            std::lock_guard<std::mutex> guard(m_tapTempo);
-            hasNewTempo = tapTempoSendUpdate;
-            newTempo = tapTempoBPM;
-            tapTempoSendUpdate = false;
-        }
-        if (hasNewTempo) sendNewTempo(newTempo);
+        workerStep();
         std::this_thread::yield();
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        currentClock().sleepFor(std::chrono::milliseconds(1));
     }
-    cout << "Thread exiting" << endl;
+    LOG_INFO("Thread exiting");
 }
 
-void Worker::sendNewTempo(double tempo) {
-    if (simulate) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
-        std::cout << "sent new tempo: " << tempo << std::endl;
-    } else {
-        setBPM(modSocket1, &m_modSocket1, tempo);
+void Worker::workerStep() {
+    // do midi events need to be processed?
+    processMidi();
+    // do we need to send the Mod the new tempo?
+    bool hasNewTempo;
+    double newTempo;
+    {
+        std::lock_guard<std::mutex> guard(m_tapTempo);
+        hasNewTempo = tapTempoSendUpdate;
+        newTempo = tapTempoBPM;
+        tapTempoSendUpdate = false;
+    }
+    if (hasNewTempo) {
+        // every unit follows the tap tempo
+        for (auto &host : hosts) {
+            host->setTempo(newTempo);
+        }
+        saveState();
+    } else if (beatTime.load(std::memory_order_relaxed) != publishedBeatTime.load(std::memory_order_relaxed)) {
+        // a tap moved the beat without changing the tempo
+        publishState();
     }
 }
 
 void Worker::processMidi() {
-    MidiEvent e;
-    std::deque<MidiEvent> events;
-    while(true) {
-        {
-            std::lock_guard<std::mutex> guard(m_midiInputEvents);
-            if (midiInputEvents.size() == 0) break;
-            events = midiInputEvents;
-            midiInputEvents.clear();
-        }
+    ModCommand command;
+    // set when a pedalboard was loaded but the status update was skipped
+    bool statusStale = false;
+    decodeMidi();
+    if (commandQueue.size() == 0) return;
+    // commands that waited too long, their pedals are still blinking
+    size_t expired = 0;
+    // background status polls hold off until we're done
+    scheduler->acquire(CommandScheduler::INTERACTIVE);
+    while(commandQueue.pop(command, &expired)) {
         // anything below this line can take as long as it needs
-        for (auto &e : events) {
-            bool updateLights = false, updateStatus = false;
-            if (e.eventType == MidiEvent::CC && e.data1 == 104) {
-                // bank up button pressed
-                if (e.data2 == 10) {
-                    std::lock_guard<std::mutex> guard(m_status);
-                    pedalboardOffset += 5;
-                    if (pedalboardOffset >= pedalboardList.size()) pedalboardOffset = 0;
-                    updateLights = true;
-                }
-                // preset button pressed
-                if (e.data2 >= 1 && e.data2 <= 5) {
-                    updateLights = loadPreset(e.data2 - 1);
-                }
-                // pedalboard button pressed
-                if ((e.data2 >= 6 && e.data2 <= 9) || e.data2 == 0) {
-                    int pedalboard = e.data2 > 0 ? e.data2 - 6 : 4;
-                    {
-                        std::lock_guard<std::mutex> guard(m_status);
-                        pedalboard += pedalboardOffset;
-                    }
-                    updateStatus = loadPedalboard(pedalboard);
+        if (command.type == ModCommand::LOAD_PRESET) {
+            loadPreset(command.index);
+            // either confirms the new preset or rolls the lights back
+            fcbUpdate();
+        } else if (loadPedalboard(command.index, command.bank)) {
+            // if a newer pedalboard load is waiting it'll do the status update
+            statusStale = commandQueue.hasPending(ModCommand::LOAD_PEDALBOARD);
+            if (!statusStale) statusUpdate(CommandScheduler::INTERACTIVE);
+        } else if (statusStale) {
+            statusStale = false;
+            statusUpdate(CommandScheduler::INTERACTIVE);
+        } else {
+            fcbUpdate();
+        }
+        // decode everything that came in while the last command was running,
+        // so rapid presses coalesce in the command queue
+        decodeMidi();
+    }
+    if (statusStale) {
+        // the newer load it was waiting for expired
+        statusUpdate(CommandScheduler::INTERACTIVE);
+    } else if (expired > 0) {
+        // roll the lights back
+        fcbUpdate();
+    }
+    scheduler->release(CommandScheduler::INTERACTIVE);
+}
+
+// turn waiting MIDI events into commands for the Mod
+void Worker::decodeMidi() {
+    ControlEvent e;
+    // presses that waited longer than maxAge are stale, don't replay them
+    while (controlEvents.pop(e, maxAge)) {
+        // bank up button pressed
+        if (e.action == ControlEvent::BANK_UP) {
+            changePage(1);
+            fcbUpdate();
+        }
+        // paging back, or on to the next bank
+        if (e.action == ControlEvent::BANK_DOWN) {
+            changePage(-1);
+            fcbUpdate();
+        }
+        if (e.action == ControlEvent::SKIP_BANK) {
+            skipBank();
+            fcbUpdate();
+        }
+        // preset button pressed
+        if (e.action == ControlEvent::PRESET) {
+            ModCommand command;
+            command.type = ModCommand::LOAD_PRESET;
+            command.index = e.index;
+            {
+                std::lock_guard<std::mutex> guard(m_status);
+                command.bundle = routedBundle;
+            }
+            routeCommand(e, command);
+        }
+        // pedalboard button pressed
+        if (e.action == ControlEvent::PEDALBOARD) {
+            ModCommand command;
+            command.type = ModCommand::LOAD_PEDALBOARD;
+            command.index = e.index;
+            {
+                std::lock_guard<std::mutex> guard(m_status);
+                command.index += pedalboardOffset;
+                command.bank = browseBankId;
+                if (command.index < shownPedalboards().size()) {
+                    command.bundle = shownPedalboards()[command.index].bundle;
+                    routedBundle = command.bundle;
                 }
             }
-            if (updateStatus) {
-                statusUpdate();
-            } else if (updateLights) {
-                fcbUpdate();
+            routeCommand(e, command);
+        }
+    }
+}
+
+// past either end of a bank the catalog has the next bank's pedalboards, so
+// nothing is asked of the Mod until one is loaded
+void Worker::changePage(int direction) {
+    std::lock_guard<std::mutex> guard(m_status);
+    if (direction > 0) {
+        pedalboardOffset += 5;
+        if (pedalboardOffset < shownPedalboards().size()) return;
+    } else if (pedalboardOffset >= 5) {
+        pedalboardOffset -= 5;
+        return;
+    }
+    showNextBank(direction);
+    // the first page going up, the last going down
+    size_t count = shownPedalboards().size();
+    pedalboardOffset = direction > 0 || count == 0 ? 0 : ((count - 1) / 5) * 5;
+}
+
+void Worker::skipBank() {
+    std::lock_guard<std::mutex> guard(m_status);
+    showNextBank(1);
+    pedalboardOffset = 0;
+}
+
+// called with m_status held
+void Worker::showNextBank(int direction) {
+    int nextId;
+    std::vector<ModPedalboard> nextList;
+    int from = browsing() ? browseBankId : modBankId;
+    if (from < 0 || !bankCatalog.next(from, direction, nextId, nextList)) return;
+    if (nextId == modBankId) {
+        browseBankId = -1;
+        browseList.clear();
+    } else {
+        browseBankId = nextId;
+        browseList = nextList;
+    }
+    LOG_DEBUG("showing bank %d", nextId);
+}
+
+// the simulated Mod has 3 banks, the first one as it always was
+static std::vector<ModPedalboard> simulatedBank(int bank) {
+    std::vector<ModPedalboard> pedalboardList;
+    ModPedalboard p;
+    if (bank == 0) {
+        for (int i=0; i<8; i++) {
+            p.title = "Patch 1";
+            p.bundle = "patch1";
+            pedalboardList.push_back(p);
+            p.title = "Patch 2";
+            p.bundle = "patch2";
+            pedalboardList.push_back(p);
+        }
+        return pedalboardList;
+    }
+    for (int i=0; i<7; i++) {
+        p.title = "Bank " + std::to_string(bank + 1) + " patch " + std::to_string(i + 1);
+        p.bundle = "bank" + std::to_string(bank + 1) + "patch" + std::to_string(i + 1);
+        pedalboardList.push_back(p);
+    }
+    return pedalboardList;
+}
+
+// keep the bank catalog current, every second until it has every bank,
+// then every 30 seconds
+void Worker::refreshCatalog() {
+    if (currentClock().now() < nextCatalogRefresh) return;
+    bool status;
+    if (simulate) {
+        std::vector<ModBank> bankList;
+        std::vector<std::vector<ModPedalboard>> pedalboardLists;
+        for (int i=0; i<3; i++) {
+            pedalboardLists.push_back(simulatedBank(i));
+            ModBank b;
+            b.id = i;
+            b.title = "Bank " + std::to_string(i + 1);
+            b.count = pedalboardLists.back().size();
+            bankList.push_back(b);
+        }
+        bankCatalog.setBanks(bankList, pedalboardLists, simulateCurrentBank);
+        status = true;
+    } else {
+        scheduler->acquire(CommandScheduler::BACKGROUND);
+        status = bankCatalog.refresh(scheduler->getSocket(CommandScheduler::BACKGROUND), scheduler->getSocketMutex(CommandScheduler::BACKGROUND));
+        scheduler->release(CommandScheduler::BACKGROUND);
+    }
+    // a Mod without get_banks won't do any better next second
+    bool more = status && !bankCatalog.isComplete();
+    nextCatalogRefresh = currentClock().now() + std::chrono::seconds(more ? 1 : 30);
+    if (!status) return;
+    int current = bankCatalog.getCurrentBank();
+    bool changed = false;
+    {
+        std::lock_guard<std::mutex> guard(m_status);
+        if (current >= 0) modBankId = current;
+        if (browsing()) {
+            // the bank being looked at may have changed or gone away
+            std::vector<ModPedalboard> list;
+            if (browseBankId == modBankId || !bankCatalog.find(browseBankId, list)) {
+                browseBankId = -1;
+                browseList.clear();
+                pedalboardOffset = 0;
+            } else {
+                browseList = list;
+                if (pedalboardOffset >= browseList.size()) pedalboardOffset = 0;
             }
+            changed = true;
         }
     }
+    if (changed) fcbUpdate();
+}
+
+// followers get their commands straight away so they load in parallel with
+// the primary, the primary's command goes through the worker loop
+void Worker::routeCommand(const ControlEvent &e, const ModCommand &command) {
+    const std::string &controller = controllers.at(e.controller)->getName();
+    for (size_t i=1; i<hosts.size(); i++) {
+        if (hosts[i]->routes(controller)) hosts[i]->submit(command);
+    }
+    if (!hosts[0]->routes(controller)) return;
+    if (command.type == ModCommand::LOAD_PRESET) {
+        showPendingPreset(command.index);
+    } else {
+        showPendingPedalboard(command.index);
+    }
+    commandQueue.push(command);
+}
+
+void Worker::setConnectTimeout(int msec) {
+    connectTimeout = std::chrono::milliseconds(msec);
+}
+
+bool Worker::setStateFile(std::string filename) {
+    return stateCache.open(filename);
+}
+
+void Worker::restoreState() {
+    double bpm = 0;
+    {
+        std::lock_guard<std::mutex> guard(m_status);
+        if (!stateCache.load(pedalboardList, presetList, currentPedalboard, currentPreset, pedalboardOffset, bpm)) return;
+        LOG_INFO("Restored cached state, pedalboard %d preset %d", currentPedalboard, currentPreset);
+    }
+    fcbUpdate();
+    if (bpm > 0) {
+        tapTempoSetBPM(bpm);
+        tapTempoPlay();
+    }
+}
+
+void Worker::saveState() {
+    double bpm;
+    {
+        std::lock_guard<std::mutex> guard(m_tapTempo);
+        bpm = tapTempoBPM;
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_status);
+        // the offset is into another bank while browsing
+        stateCache.save(pedalboardList, presetList, currentPedalboard, currentPreset, browsing() ? 0 : pedalboardOffset, bpm);
+    }
+    publishState();
+}
+
+bool Worker::setStatePage(std::string name) {
+    return statePage.open(name);
+}
+
+static void copyTitle(char *dest, const std::string &src) {
+    strncpy(dest, src.c_str(), StatePageData::TITLE_SIZE - 1);
+    dest[StatePageData::TITLE_SIZE - 1] = 0;
+}
+
+void Worker::publishState() {
+    double bpm;
+    {
+        std::lock_guard<std::mutex> guard(m_tapTempo);
+        bpm = tapTempoBPM;
+    }
+    uint64_t beat = beatTime.load(std::memory_order_relaxed);
+    StatePageData *page = statePage.begin();
+    if (!page) return;
+    {
+        std::lock_guard<std::mutex> guard(m_status);
+        page->hosts = hosts.size();
+        page->statusOk = statusOk;
+        page->statusTime = statusTime;
+        page->pedalboard = currentPedalboard;
+        page->preset = currentPreset;
+        page->pedalboardOffset = pedalboardOffset;
+        page->pedalboardCount = shownPedalboards().size();
+        page->presetCount = presetList.size();
+        bool hasPedalboard = currentPedalboard >= 0 && currentPedalboard < (int)pedalboardList.size();
+        copyTitle(page->pedalboardTitle, hasPedalboard ? pedalboardList[currentPedalboard].title : "");
+        bool hasPreset = currentPreset >= 0 && currentPreset < (int)presetList.size();
+        copyTitle(page->presetTitle, hasPreset ? presetList[currentPreset] : "");
+        for (int i=0; i<StatePageData::SWITCHES; i++) {
+            size_t index = pedalboardOffset + i;
+            copyTitle(page->switchTitles[i], index < shownPedalboards().size() ? shownPedalboards()[index].title : "");
+        }
+    }
+    page->bpm = bpm;
+    page->beatTime = beat;
+    statePage.end();
+    publishedBeatTime = beat;
+}
+
+void Worker::refreshLights(jack_port_t *outputPort) {
+    for (auto &c : controllers) {
+        if (c->getOutputPort() != outputPort) continue;
+        c->getLights().markAllDirty();
+        c->resync();
+    }
+}
+
+void Worker::setMaxAge(int msec) {
+    maxAge = std::chrono::milliseconds(msec);
+    commandQueue.setMaxAge(maxAge);
 }
 
 // called from jack's realtime thread
 void Worker::jackProcess(jack_nframes_t nframes) {
-    std::lock_guard<std::mutex> guard(m_midiOutputEvents);
+    // long presses & repeats of switches that are still down
+    for (size_t i=0; i<controllers.size(); i++) {
+        ControlEvent e;
+        while (controllers[i]->getGestures().poll(cycleStart, cycleStart + nframes, e)) {
+            e.controller = i;
+            injectControl(e, nframes);
+        }
+    }
     tapTempoProcess(nframes);
-    auto temp = fcbLights.getMidiEvents();
-    midiOutputEvents.insert(midiOutputEvents.end(), temp.begin(), temp.end());
+    expressions.process(nframes, sampleRate);
+    // blink any pedals that are waiting on the Mod, about 4 times a second
+    if (blinkCountdown <= nframes) {
+        blinkCountdown = sampleRate / 8;
+        blinkOn = !blinkOn;
+        for (auto &c : controllers) {
+            c->getLights().setBlinkState(blinkOn);
+        }
+    } else {
+        blinkCountdown -= nframes;
+    }
+    // each controller only gets the lights that changed on it
+    for (auto &c : controllers) {
+        metricLEDMessages->inc(c->queueLights());
+    }
     {
         std::lock_guard<std::mutex> guard(m_nextStatusUpdate);
         if (nextStatusUpdate < nframes) {
@@ -258,29 +677,41 @@ void Worker::jackProcess(jack_nframes_t nframes) {
             nextStatusUpdate -= nframes;
         }
     }
+    cycleStart += nframes;
 }
 
-void Worker::setHostname(std::string hostname) {
-    this->hostname = hostname;
-}
-
-bool Worker::loadPedalboard(unsigned int pedalboard) {
-    //std::cout << "load pedalboard " << pedalboard << std::endl;
-    tapTempoPause();
+bool Worker::loadPedalboard(unsigned int pedalboard, int bank) {
+    LOG_DEBUG("load pedalboard %u from bank %d", pedalboard, bank);
+    std::vector<ModPedalboard> bankList;
+    // the bank may have been browsed away from since the press
+    if (bank >= 0 && !bankCatalog.find(bank, bankList)) return false;
     {
         std::lock_guard<std::mutex> guard(m_status);
-        if (pedalboard >= pedalboardList.size()) return false;
+        if (pedalboard >= (bank >= 0 ? bankList.size() : pedalboardList.size())) return false;
     }
+    tapTempoPause();
+    // m_status isn't held while the Mod loads, so status updates & the
+    // catalog carry on in their own lanes
+    bool status;
     if (simulate) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        currentClock().sleepFor(std::chrono::milliseconds(1000));
+        if (bank >= 0) simulateCurrentBank = bank;
         simulateCurrentPedalboard = pedalboard;
         simulateCurrentPreset = 0;
         simulateCurrentBPM = 120;
-        return true;
+        status = true;
     } else {
-        std::lock_guard<std::mutex> guard(m_status);
-        return ::loadPedalboard(modSocket1, &m_modSocket1, pedalboard);
+        metricPedalboardLoads->inc();
+        status = ::loadPedalboard(scheduler->getSocket(CommandScheduler::INTERACTIVE), scheduler->getSocketMutex(CommandScheduler::INTERACTIVE), pedalboard, bank);
     }
+    if (!status || bank < 0) return status;
+    // the Mod has moved to the new bank, the status update confirms it
+    std::lock_guard<std::mutex> guard(m_status);
+    modBankId = bank;
+    pedalboardList = bankList;
+    browseBankId = -1;
+    browseList.clear();
+    return true;
 }
 
 bool Worker::loadPreset(unsigned int preset) {
@@ -290,142 +721,239 @@ bool Worker::loadPreset(unsigned int preset) {
     }
     if (simulate) {
         simulateCurrentPreset = preset;
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        currentClock().sleepFor(std::chrono::milliseconds(10));
         std::lock_guard<std::mutex> guard(m_status);
         currentPreset = simulateCurrentPreset;
         return true;
     } else {
-        if (!::loadPreset(modSocket2, &m_modSocket2, preset)) return false;
+        metricPresetLoads->inc();
+        if (!::loadPreset(scheduler->getSocket(CommandScheduler::INTERACTIVE), scheduler->getSocketMutex(CommandScheduler::INTERACTIVE), preset)) return false;
         std::lock_guard<std::mutex> guard(m_status);
         currentPreset = preset;
         return true;
     }
 }
 
-void Worker::statusUpdate() {
-    std::string response, contentType;
-    std::string url;
+// returns false if a background update was cut short by interactive work
+bool Worker::statusUpdate(CommandScheduler::Priority priority) {
+    int socket = scheduler->getSocket(priority);
+    std::mutex *socketMutex = scheduler->getSocketMutex(priority);
     bool status;
+    // the state page shows if anything went wrong
+    bool healthy = true;
+    // everything is fetched into these and only applied once the whole pass
+    // is done, so a pass that yields leaves nothing half updated, and an
+    // interactive pass can run alongside a background one
+    std::vector<ModPedalboard> newPedalboardList;
+    std::vector<std::string> newPresetList;
+    int newPedalboard = -1, newPreset = -1;
+    unsigned int oldOffset = 0, newOffset = 0;
     
+    metricStatusUpdates->inc();
+    flightRecorder().record(FlightRecorder::BEGIN, "status_update");
     if (simulate) {
         status = true;
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
-        std::lock_guard<std::mutex> guard(m_status);
-        pedalboardList.clear();
-        ModPedalboard p;
-        for (int i=0; i<8; i++) {
-            p.title = "Patch 1";
-            p.bundle = "patch1";
-            pedalboardList.push_back(p);
-            p.title = "Patch 2";
-            p.bundle = "patch2";
-            pedalboardList.push_back(p);
-        }
+        currentClock().sleepFor(std::chrono::milliseconds(20));
+        newPedalboardList = simulatedBank(simulateCurrentBank);
     } else {
-        status = getPedalboardList(modSocket1, &m_modSocket1, pedalboardList, &m_status);
+        status = getPedalboardList(socket, socketMutex, newPedalboardList, NULL);
     }
-    if (!status) std::cout << "Error getting current bank" << std::endl;
+    if (!status) LOG_ERROR("Error getting current bank");
+    healthy = healthy && status;
     if (debug) {
-        std::lock_guard<std::mutex> guard(m_status);
-        std::cout << "Current bank:" << std::endl;
-        for (size_t i=0; i<pedalboardList.size(); i++) {
-            std::cout << std::to_string(i) << ": " << pedalboardList.at(i).title << std::endl;
+        LOG_DEBUG("Current bank:");
+        for (size_t i=0; i<newPedalboardList.size(); i++) {
+            LOG_DEBUG("%u: %s", (unsigned int)i, newPedalboardList.at(i).title.c_str());
         }
-        if (pedalboardList.size() == 0) {
-            std::cout << "Current bank is empty." << std::endl;
+        if (newPedalboardList.size() == 0) {
+            LOG_DEBUG("Current bank is empty.");
         }
     }
 
+    if (scheduler->shouldYield(priority)) {
+        flightRecorder().record(FlightRecorder::END, "status_update");
+        return false;
+    }
     if (simulate) {
         status = true;
-        std::this_thread::sleep_for(std::chrono::milliseconds(15));
-        std::lock_guard<std::mutex> guard(m_status);
-        presetList.clear();
-        presetList.push_back("clean");
-        presetList.push_back("OD");
-        presetList.push_back("solo");
+        currentClock().sleepFor(std::chrono::milliseconds(15));
+        newPresetList.push_back("clean");
+        newPresetList.push_back("OD");
+        newPresetList.push_back("solo");
     } else {
-        status = getPresetList(modSocket1, &m_modSocket1, presetList, &m_status);
+        status = getPresetList(socket, socketMutex, newPresetList, NULL);
     }
-    if (!status) std::cout << "Error getting preset list" << std::endl;
+    if (!status) LOG_ERROR("Error getting preset list");
+    healthy = healthy && status;
+    flightRecorder().record(FlightRecorder::STATE, "bank", newPedalboardList.size(), newPresetList.size());
     if (debug) {
-        std::lock_guard<std::mutex> guard(m_status);
-        std::cout << "Preset list:" << std::endl;
-        for (size_t i=0; i<presetList.size(); i++) {
-            std::cout << std::to_string(i) << ": " << presetList.at(i) << std::endl;
+        LOG_DEBUG("Preset list:");
+        for (size_t i=0; i<newPresetList.size(); i++) {
+            LOG_DEBUG("%u: %s", (unsigned int)i, newPresetList.at(i).c_str());
         }
-        if (presetList.size() == 0) {
-            std::cout << "Current patch has no presets." << std::endl;
+        if (newPresetList.size() == 0) {
+            LOG_DEBUG("Current patch has no presets.");
         }
     }
     
+    if (scheduler->shouldYield(priority)) {
+        flightRecorder().record(FlightRecorder::END, "status_update");
+        return false;
+    }
     if (simulate) {
         status = true;
-        std::this_thread::sleep_for(std::chrono::milliseconds(15));
-        std::lock_guard<std::mutex> guard(m_status);
-        currentPedalboard = simulateCurrentPedalboard;
-        currentPreset = simulateCurrentPreset;
+        currentClock().sleepFor(std::chrono::milliseconds(15));
+        newPedalboard = simulateCurrentPedalboard;
+        newPreset = simulateCurrentPreset;
     } else {
-        status = getCurrentPedalboardAndPreset(modSocket1, &m_modSocket1, pedalboardList, currentPedalboard, currentPreset, pedalboardOffset, &m_status);
+        // while browsing the offset belongs to another bank, leave it alone
+        {
+            std::lock_guard<std::mutex> guard(m_status);
+            oldOffset = newOffset = browsing() ? 0 : pedalboardOffset;
+        }
+        status = getCurrentPedalboardAndPreset(socket, socketMutex, newPedalboardList, newPedalboard, newPreset, newOffset, NULL);
     }
-    if (!status) std::cout << "Error getting current pedalboard & preset" << std::endl;
+    if (!status) LOG_ERROR("Error getting current pedalboard & preset");
+    healthy = healthy && status;
+    flightRecorder().record(FlightRecorder::STATE, "pedalboard", newPedalboard, newPreset);
 
     if (debug) {
-        std::cout << "Current pedalboard: " << std::to_string(currentPedalboard) << std::endl;
-        if (currentPedalboard >= 0) {
-            std::cout << pedalboardList.at(currentPedalboard).title << std::endl;
+        LOG_DEBUG("Current pedalboard: %d", newPedalboard);
+        if (newPedalboard >= 0 && newPedalboard < (int)newPedalboardList.size()) {
+            LOG_DEBUG("%s", newPedalboardList.at(newPedalboard).title.c_str());
         } else {
-            std::cout << "None" << std::endl;
+            LOG_DEBUG("None");
         }
-        std::cout << "Current preset: " << std::to_string(currentPreset) << std::endl;
-        if (currentPreset >= 0) {
-            std::cout << presetList.at(currentPreset) << std::endl;
+        LOG_DEBUG("Current preset: %d", newPreset);
+        if (newPreset >= 0 && newPreset < (int)newPresetList.size()) {
+            LOG_DEBUG("%s", newPresetList.at(newPreset).c_str());
         } else {
-            std::cout << "None" << std::endl;
+            LOG_DEBUG("None");
         }
     }
     
+    if (scheduler->shouldYield(priority)) {
+        flightRecorder().record(FlightRecorder::END, "status_update");
+        return false;
+    }
     double bpm;
+    bool bpmStatus;
     if (simulate) {
-        status = true;
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        bpmStatus = true;
+        currentClock().sleepFor(std::chrono::milliseconds(10));
         bpm = simulateCurrentBPM;
     } else {
-        status = getCurrentBPM(modSocket1, &m_modSocket1, bpm, NULL);
+        bpmStatus = getCurrentBPM(socket, socketMutex, bpm, NULL);
+    }
+    if (!bpmStatus) {
+        LOG_ERROR("Error getting current BPM");
+        healthy = false;
+    }
+
+    // the whole pass made it, apply it in one go
+    {
+        std::lock_guard<std::mutex> guard(m_status);
+        // the Mod moved to another pedalboard on its own, presets follow it
+        std::string oldBundle = currentPedalboard >= 0 && currentPedalboard < (int)pedalboardList.size() ? pedalboardList[currentPedalboard].bundle : "";
+        std::string newBundle = newPedalboard >= 0 && newPedalboard < (int)newPedalboardList.size() ? newPedalboardList[newPedalboard].bundle : "";
+        if (newBundle != oldBundle || routedBundle.empty()) routedBundle = newBundle;
+        pedalboardList = newPedalboardList;
+        presetList = newPresetList;
+        currentPedalboard = newPedalboard;
+        currentPreset = newPreset;
+        // only if the offset had to be moved into range, a page press while
+        // we were waiting on the Mod wins otherwise
+        if (!browsing() && newOffset != oldOffset) pedalboardOffset = newOffset;
+        statusOk = healthy;
+        statusTime = statePageNow();
     }
-    if (status) {
+    if (bpmStatus) {
         if (debug) {
-            std::cout << "Current BPM: " << bpm << std::endl;
+            LOG_DEBUG("Current BPM: %f", bpm);
         }
         tapTempoSetBPM(bpm);
-    } else {
-        std::cout << "Error getting current BPM" << std::endl;
+        // keep the other units at the primary's tempo
+        hosts[0]->syncTempo(bpm);
+        for (size_t i=1; i<hosts.size(); i++) {
+            hosts[i]->setTempo(bpm);
+        }
     }
-
     {
         std::lock_guard<std::mutex> guard(m_nextStatusUpdate);
         nextStatusUpdate = sampleRate * 10;
     }
     fcbUpdate();
     tapTempoPlay();
+    flightRecorder().record(FlightRecorder::END, "status_update", 0, 1);
+    return true;
 }
 
 void Worker::fcbUpdate() {
-    std::lock_guard<std::mutex> guard(m_status);
-    // update the LEDs
-    for (int i=0; i<5; i++) {
-        fcbLights.setPedal(i, i == currentPreset);
-        fcbLights.setPedal(i + 5, (i + (int)pedalboardOffset) == currentPedalboard);
+    {
+        std::lock_guard<std::mutex> guard(m_status);
+        // update the LEDs, every controller shows the same state
+        for (auto &c : controllers) {
+            FCBLights &lights = c->getLights();
+            // the current pedalboard isn't in a bank that's only being browsed
+            int shownPedalboard = browsing() ? -1 : currentPedalboard;
+            for (int i=0; i<5; i++) {
+                lights.setPedal(i, i == currentPreset);
+                lights.setPedal(i + 5, (i + (int)pedalboardOffset) == shownPedalboard);
+            }
+            for (int i=0; i<13; i++) {
+                lights.setMiscLight(i, false);
+            }
+            if (shownPedalboard >= (int)pedalboardOffset && (shownPedalboard - (int)pedalboardOffset) < 5) {
+                lights.setMiscLight(12, false);
+                lights.setDigits(currentPedalboard + 1);
+            } else {
+                lights.setMiscLight(12, true);
+                lights.setDigits(pedalboardOffset + 1);
+            }
+        }
     }
-    for (int i=0; i<13; i++) {
-        fcbLights.setMiscLight(i, false);
+    // whatever the lights show is worth remembering
+    saveState();
+}
+
+// light the pressed preset pedal right away, fcbUpdate() settles it once the
+// Mod has answered
+void Worker::showPendingPreset(unsigned int preset) {
+    {
+        std::lock_guard<std::mutex> guard(m_status);
+        if (preset >= presetList.size()) return;
     }
-    if (currentPedalboard >= (int)pedalboardOffset && (currentPedalboard - (int)pedalboardOffset) < 5) {
-        fcbLights.setMiscLight(12, false);
-        fcbLights.setDigits(currentPedalboard + 1);
-    } else {
-        fcbLights.setMiscLight(12, true);
-        fcbLights.setDigits(pedalboardOffset + 1);
+    for (auto &c : controllers) {
+        for (unsigned int i=0; i<5; i++) {
+            if (i == preset) {
+                c->getLights().setPending(i);
+            } else {
+                c->getLights().setPedal(i, false);
+            }
+        }
+    }
+}
+
+void Worker::showPendingPedalboard(unsigned int pedalboard) {
+    unsigned int offset;
+    {
+        std::lock_guard<std::mutex> guard(m_status);
+        if (pedalboard >= shownPedalboards().size()) return;
+        offset = pedalboardOffset;
+    }
+    for (auto &c : controllers) {
+        FCBLights &lights = c->getLights();
+        // the new pedalboard's presets aren't known yet
+        for (unsigned int i=0; i<5; i++) {
+            lights.setPedal(i, false);
+            if (i + offset == pedalboard) {
+                lights.setPending(i + 5);
+            } else {
+                lights.setPedal(i + 5, false);
+            }
+        }
+        lights.setMiscLight(12, false);
+        lights.setDigits(pedalboard + 1);
     }
 }
 
@@ -434,6 +962,7 @@ void Worker::tapTempoPause() {
     tapTempoPaused = true;
     tapTempoLastTime = -1;
     tapTempoBPMs.clear();
+    beatTime = 0;
 }
 
 void Worker::tapTempoPlay() {
@@ -443,7 +972,19 @@ void Worker::tapTempoPlay() {
     tapTempoBPMs.clear();
 }
 
-// called from the jack realtime thread with a lock already on midiOutputEvents
+// called from the jack realtime thread
+void Worker::queueTempoLight(bool on, jack_nframes_t time) {
+    MidiEvent e;
+    e.eventType = MidiEvent::CC;
+    e.data1 = on ? 106 : 107;
+    e.data2 = 16;
+    e.time = time;
+    for (auto &c : controllers) {
+        c->queueOutput(e);
+    }
+}
+
+// called from the jack realtime thread
 void Worker::tapTempoProcess(jack_nframes_t nframes) {
     std::lock_guard<std::mutex> guard(m_tapTempo);
     if (tapTempoLastTime >= 0) tapTempoLastTime += nframes;
@@ -456,34 +997,20 @@ void Worker::tapTempoProcess(jack_nframes_t nframes) {
     if (tapTempoPaused || tapTempoLength == 0) {
         if (tapTempoLightOn) {
             // turn it off
-            MidiEvent e;
-            e.eventType = MidiEvent::CC;
-            e.data1 = 107;
-            e.data2 = 16;
-            midiOutputEvents.push_back(e);
+            queueTempoLight(false, 0);
             tapTempoLightOn = false;
         }
         return;
     }
     if (tapTempoNextOn < nframes) {
-        MidiEvent e;
-        e.eventType = MidiEvent::CC;
-        e.data1 = 106;
-        e.data2 = 16;
-        e.time = tapTempoNextOn;
-        midiOutputEvents.push_back(e);
+        queueTempoLight(true, tapTempoNextOn);
         tapTempoLightOn = true;
         tapTempoNextOn += tapTempoLength;
     } else {
         tapTempoNextOn -= nframes;
     }
     if (tapTempoNextOff < nframes) {
-        MidiEvent e;
-        e.eventType = MidiEvent::CC;
-        e.data1 = 107;
-        e.data2 = 16;
-        e.time = tapTempoNextOff;
-        midiOutputEvents.push_back(e);
+        queueTempoLight(false, tapTempoNextOff);
         tapTempoLightOn = false;
         tapTempoNextOff += tapTempoLength;
     } else {
@@ -493,10 +1020,16 @@ void Worker::tapTempoProcess(jack_nframes_t nframes) {
 
 void Worker::tapTempoSetBPM(double newBPM) {
     std::lock_guard<std::mutex> guard(m_tapTempo);
+    // the same tempo, e.g. every status update after a tap, keeps the phase
+    // the tap set
+    if (tapTempoLength > 0 && beatTime != 0 && std::abs(newBPM - tapTempoBPM) <= .01) return;
     tapTempoBPM = newBPM;
     tapTempoLength = ((double)sampleRate * 60.0) / tapTempoBPM;
-    tapTempoNextOn = 0;
-    tapTempoNextOff = tapTempoLength / 4;
+    // the beat starts now, the light is sent early for the next one
+    jack_nframes_t lead = tapTempoLength > 0 ? tempoLead % tapTempoLength : 0;
+    tapTempoNextOn = lead > 0 ? tapTempoLength - lead : 0;
+    tapTempoNextOff = tapTempoNextOn + tapTempoLength / 4;
+    beatTime = statePageNow();
 }
 
 // called from the jack realtime thread
@@ -524,6 +1057,12 @@ void Worker::tapTempoTap(jack_nframes_t frame, jack_nframes_t nframes) {
         tapTempoLength = ((double)sampleRate * 60.0) / tapTempoBPM;
     }
     tapTempoLastTime = nframes - frame;
-    tapTempoNextOn = 0;
-    tapTempoNextOff = tapTempoLength / 4;
+    flightRecorder().record(FlightRecorder::TAP, "", (uint32_t)(tapTempoBPM * 100), frame);
+    // the tap was on the beat, flash for the next one early enough that the
+    // light comes on with it (or with this one if there's no latency)
+    jack_nframes_t lead = tapTempoLength > 0 ? tempoLead % tapTempoLength : 0;
+    tapTempoNextOn = frame + tapTempoLength - lead;
+    if (tapTempoNextOn >= tapTempoLength) tapTempoNextOn -= tapTempoLength;
+    tapTempoNextOff = tapTempoNextOn + tapTempoLength / 4;
+    beatTime = statePageNow();
 }
\ No newline at end of file
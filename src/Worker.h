@@ -14,36 +14,87 @@
 #include <deque>
 #include <vector>
 #include <atomic>
+#include <memory>
 
 #include "MidiEvent.h"
 #include "Utilities.h"
 #include "FCBLights.h"
+#include "Metrics.h"
+#include "CommandQueue.h"
+#include "CommandScheduler.h"
+#include "BoundedQueue.h"
+#include "ModHost.h"
+#include "Expression.h"
+#include "StateCache.h"
+#include "StatePage.h"
+#include "BankCatalog.h"
+#include "Controller.h"
+#include "Clock.h"
 
 class Worker {
 public:
-    Worker(jack_client_t *client, jack_port_t *inputPort, jack_port_t* outputPort);
+    Worker(jack_client_t *client);
     virtual ~Worker();
+    // controllers must all be added before start()
+    void addController(std::string name, jack_port_t *inputPort, jack_port_t *outputPort, const DeviceProfile &profile);
+    void addExpression(const ExpressionMapping &mapping);
+    void setExpressionSmoothing(int msec);
+    void setExpressionRate(int perSecond);
+    // these apply to all the controllers added so far
+    void setThru(const ThruFilter &filter, unsigned int budget);
+    void setLinkRate(unsigned int bytesPerSecond);
+    void setRunningStatus(bool enabled, int resyncMsec);
+    void setGestureTimes(const GestureTimes &times);
     bool start();
+    // for simulated sessions, nothing is connected and no threads are started,
+    // the session calls the step functions & jackProcess() itself
+    bool startSimulation();
     void stop();
-    bool midiInput(void* port_buf, jack_nframes_t nframes);
-    bool midiOutput(void* port_buf, jack_nframes_t nframes);
+    void workerStep();
+    void statusStep();
+    // a decoded press or release from a controller, turned into gestures
+    void switchInput(ControlEvent e, jack_nframes_t nframes);
+    // feed a gesture in as if it came from a controller
+    void injectControl(ControlEvent e, jack_nframes_t nframes);
+    void getState(int &pedalboard, int &preset, double &bpm);
+    bool midiInput(jack_nframes_t nframes);
+    bool midiOutput(jack_nframes_t nframes);
     void jackProcess(jack_nframes_t nframes);
-    void setHostname(std::string hostname);
+    // the first host added is the primary, the lights show its state, routes
+    // are the controllers whose commands go to the host (empty for all)
+    void addHost(std::string hostname, std::vector<std::string> routes);
     void setSimulate(bool simulate);
     void setDebug(bool debug);
     void setTempoLight(bool tempoLight);
+    void setTempoInterval(int msec);
+    // time the controller itself takes to act on MIDI, on top of what jack
+    // reports, the tempo light is sent this much earlier
+    void setDeviceLatency(int msec);
+    // jack's latency callback, called from a jack non-realtime thread
+    void updateLatency(jack_latency_callback_mode_t mode);
+    void setMaxAge(int msec);
+    // resend all the lights of the controller using this output port
+    void refreshLights(jack_port_t *outputPort);
+    void setConnectTimeout(int msec);
+    bool setStateFile(std::string filename);
+    // show the cached state until the first status update, call before start()
+    void restoreState();
+    // publish the state in shared memory for other programs, e.g. "/modmidi"
+    bool setStatePage(std::string name);
 private:
-    std::string hostname = "localhost";
     jack_nframes_t nextStatusUpdate = 0;
     std::mutex m_nextStatusUpdate;
-    std::deque<MidiEvent> midiInputEvents;
-    std::deque<MidiEvent> midiOutputEvents;
-    std::mutex m_midiInputEvents, m_midiOutputEvents;
+    // presses from all the controllers, in the order they happened
+    // bounded so a stalled Mod can't build up an endless backlog of presses
+    BoundedQueue<ControlEvent> controlEvents{"midi_input", 64, BoundedQueue<ControlEvent>::DROP_OLDEST};
+    std::chrono::milliseconds maxAge{3000};
     jack_client_t *client;
-    jack_port_t *inputPort, *outputPort;
+    std::vector<std::unique_ptr<Controller>> controllers;
     void threadWork();
     void statusUpdateThreadWork();
     void processMidi();
+    void decodeMidi();
+    CommandQueue commandQueue;
     std::thread worker_thread;
     std::thread status_update_thread;
     bool worker_quit = false;
@@ -52,10 +103,20 @@ private:
     std::mutex m_needToUpdateLEDS;
     
     bool loadPreset(unsigned int preset);
-    bool loadPedalboard(unsigned int pedalboard);
-    void statusUpdate();
+    bool loadPedalboard(unsigned int pedalboard, int bank);
+    bool statusUpdate(CommandScheduler::Priority priority);
     void fcbUpdate();
-    void sendNewTempo(double tempo);
+    void saveState();
+    void publishState();
+    void showPendingPreset(unsigned int preset);
+    void showPendingPedalboard(unsigned int pedalboard);
+    void routeCommand(const ControlEvent &e, const ModCommand &command);
+    // show the next (or previous) 5 pedalboards
+    void changePage(int direction);
+    // show the start of the next bank
+    void skipBank();
+    void showNextBank(int direction);
+    void refreshCatalog();
     
     // the following variables are all protected by m_status
     std::vector<ModPedalboard> pedalboardList;
@@ -64,6 +125,20 @@ private:
     int currentPreset = -1;
     int sampleRate = 0;
     unsigned int pedalboardOffset = 0;
+    // whether the last status update got everything, and when it finished
+    bool statusOk = false;
+    uint64_t statusTime = 0;
+    // the Mod's current bank in the catalog, and the bank being looked at on
+    // the controller when it's a different one (-1 when it isn't)
+    int modBankId = -1;
+    int browseBankId = -1;
+    std::vector<ModPedalboard> browseList;
+    bool browsing() { return browseBankId >= 0; }
+    // the pedalboards on the switches, called with m_status held
+    const std::vector<ModPedalboard> &shownPedalboards() { return browsing() ? browseList : pedalboardList; }
+    // the bundle of the last pedalboard sent to the hosts, presets go with it
+    // even before the primary has confirmed the load
+    std::string routedBundle;
     std::mutex m_status;
     
     // the following variables are all protected by m_tapTempo
@@ -81,12 +156,26 @@ private:
     void tapTempoPlay();
     void tapTempoTap(jack_nframes_t frame, jack_nframes_t nframes);
     void tapTempoProcess(jack_nframes_t nframes);
+    // switch the tempo light on every controller at a frame in this cycle
+    void queueTempoLight(bool on, jack_nframes_t time);
     void tapTempoSetBPM(double newBPM);
     
-    FCBLights fcbLights;
+    // how much earlier than the beat the tempo light is sent, in frames, so
+    // it lights on the beat rather than a round trip after it
+    std::atomic<jack_nframes_t> deviceLatency{0}, tempoLead{0};
+    void updateTempoLead();
+    
+    // frames since the worker started, at the start of the current cycle,
+    // only used on the jack thread
+    uint64_t cycleStart = 0;
+
+    // frames until the pending pedal blink toggles, only used on the jack thread
+    jack_nframes_t blinkCountdown = 0;
+    bool blinkOn = true;
     
     // simulate mode stuff
     bool simulate = false;
+    int simulateCurrentBank = 0;
     int simulateCurrentPedalboard = 0;
     int simulateCurrentPreset = 0;
     double simulateCurrentBPM = 120.0;
@@ -97,10 +186,33 @@ private:
     // is the tempo light enabled?
     bool tempoLightEnabled = false;
     
-    // socket stuff
-    int modSocket1 = -1;
-    int modSocket2 = -1;
-    std::mutex m_modSocket1, m_modSocket2;
+    // metrics, registered in the constructor
+    Counter *metricMidiIn, *metricMidiOut, *metricLEDMessages, *metricTaps, *metricConnects;
+    Counter *metricStatusUpdates, *metricPedalboardLoads, *metricPresetLoads;
+    Gauge *metricTempoLead;
+    
+    // the Mod units, each owns its own connections
+    std::vector<std::unique_ptr<ModHost>> hosts;
+    // the primary host's scheduler, set by start()
+    CommandScheduler *scheduler = NULL;
+    int tempoInterval = 100;
+    
+    // expression pedals, fed from the jack thread & sent by each host
+    ExpressionMap expressions;
+    int expressionRate = 30;
+    std::chrono::milliseconds connectTimeout{10000};
+    
+    // every bank's pedalboards, refreshed from the status thread
+    BankCatalog bankCatalog;
+    Clock::time_point nextCatalogRefresh;
+
+    // last known state, for a quick warm start
+    StateCache stateCache;
+    // the state for other programs, beatTime is when a beat started (set on
+    // the jack thread), the worker republishes when it moves
+    StatePage statePage;
+    std::atomic<uint64_t> beatTime{0};
+    std::atomic<uint64_t> publishedBeatTime{0};
 };
 
 #endif /* WORKER_H */
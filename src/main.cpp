@@ -16,70 +16,86 @@
 
 #include "Worker.h"
 #include "Utilities.h"
+#include "MetricsServer.h"
+#include "PortConnector.h"
+#include "Log.h"
+#include "Session.h"
+#include "Realtime.h"
+#include "FlightRecorder.h"
 
 using namespace std;
 
 jack_client_t *client = NULL;
-jack_port_t *input_port, *output_port;
 
 Worker *worker = NULL;
 
 static void signal_handler(int sig) {
-    cerr << "Signal received, exiting ..." << endl;
+    LOG_INFO("Signal received, exiting ...");
     signalQuit();
 }
 
+static void dump_handler(int sig) {
+    // only posts a semaphore, the dumper thread does the work
+    flightRecorder().requestDump();
+}
+
+// Jack xrun callback
+static int xrun(void *arg) {
+    static Counter *xruns = metrics().counter("modmidi_xruns_total", "Jack xruns");
+    xruns->inc();
+    flightRecorder().record(FlightRecorder::XRUN, "");
+    return 0;
+}
+
+// Jack latency callback
+static void latency(jack_latency_callback_mode_t mode, void *arg) {
+    if (worker) worker->updateLatency(mode);
+}
+
 // Jack process callback
 static int process(jack_nframes_t nframes, void *arg) {
+    // label jack's thread in the flight recorder
+    static bool threadNamed = false;
+    if (!threadNamed) {
+        flightRecorder().nameThread("jack");
+        threadNamed = true;
+    }
     if (!worker) return 0;
     // give MIDI input to the worker
-    void* port_buf = jack_port_get_buffer(input_port, nframes);
-    worker->midiInput(port_buf, nframes);
+    worker->midiInput(nframes);
     // call the worker's process function
     worker->jackProcess(nframes);
     // get MIDI output from the worker
-    port_buf = jack_port_get_buffer(output_port, nframes);
-    worker->midiOutput(port_buf, nframes);
+    worker->midiOutput(nframes);
     return 0;
 }
 
-// utility function to find a jack port
-std::string getPort(std::string regEx, unsigned long flags) {
-    const char **ports;
-    ports = jack_get_ports(client, regEx.c_str(), JACK_DEFAULT_MIDI_TYPE, flags);
-    if (!ports) return "";
+class ControllerOption {
+public:
+    std::string name, input, output, profile = "fcb1010";
+    jack_port_t *inputPort = NULL, *outputPort = NULL;
+};
 
-    const char *port = ports[0];
-    std::string retVal = "";
-    if (port) {
-        retVal = port;
+static std::vector<std::string> splitString(std::string s, char separator) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (true) {
+        size_t found = s.find(separator, start);
+        parts.push_back(s.substr(start, found == std::string::npos ? std::string::npos : found - start));
+        if (found == std::string::npos) break;
+        start = found + 1;
     }
-    jack_free(ports);
-    return retVal;
+    return parts;
 }
 
-// attempt to connect the ports
-bool connectPorts(std::string inputPortRegEx, std::string outputPortRegEx) {
-    std::cout << "attempting to connect ports..." << std::endl;
-    if (!jack_port_connected(input_port)) {
-        std::string inputPortName = getPort(inputPortRegEx, JackPortIsOutput);
-        if (inputPortName.length() > 0) {
-            int retval = jack_connect(client, inputPortName.c_str(), jack_port_name(input_port));
-            if (retval == 0) {
-                std::cout << "connected " << inputPortName << " to input port" << std::endl;
-            }
-        }
-    }
-    if (!jack_port_connected(output_port)) {
-        std::string outputPortName = getPort(outputPortRegEx, JackPortIsInput);
-        if (outputPortName.length() > 0) {
-            int retval = jack_connect(client, jack_port_name(output_port), outputPortName.c_str());
-            if (retval == 0) {
-                std::cout << "connected output port to " << outputPortName << std::endl;
-            }
-        }
-    }
-    if (!jack_port_connected(input_port) || !jack_port_connected(output_port)) return false;
+// parses NAME,INPUT,OUTPUT[,PROFILE]
+static bool parseController(std::string spec, ControllerOption &option) {
+    std::vector<std::string> parts = splitString(spec, ',');
+    if (parts.size() < 3 || parts.size() > 4 || parts[0].size() == 0) return false;
+    option.name = parts[0];
+    option.input = parts[1];
+    option.output = parts[2];
+    if (parts.size() == 4) option.profile = parts[3];
     return true;
 }
 
@@ -93,6 +109,30 @@ int main(int argc, char** argv) {
         {"flash", no_argument, NULL, 'f'},
         {"debug", no_argument, NULL, 'd'},
         {"simulate", no_argument, NULL, 's'},
+        {"metrics", required_argument, NULL, 'm'},
+        {"tempo-interval", required_argument, NULL, 't'},
+        {"max-age", required_argument, NULL, 'a'},
+        {"connect-timeout", required_argument, NULL, 'c'},
+        {"state-file", required_argument, NULL, 'S'},
+        {"controller", required_argument, NULL, 'C'},
+        {"thru", required_argument, NULL, 'T'},
+        {"thru-budget", required_argument, NULL, 'b'},
+        {"expression", required_argument, NULL, 'e'},
+        {"expression-rate", required_argument, NULL, 'E'},
+        {"expression-smoothing", required_argument, NULL, 'g'},
+        {"link-rate", required_argument, NULL, 'l'},
+        {"running-status", no_argument, NULL, 'r'},
+        {"resync", required_argument, NULL, 'y'},
+        {"session", required_argument, NULL, 'x'},
+        {"sessions", required_argument, NULL, 'N'},
+        {"seed", required_argument, NULL, 'R'},
+        {"jitter", required_argument, NULL, 'j'},
+        {"thread", required_argument, NULL, 'P'},
+        {"lock-memory", no_argument, NULL, 'L'},
+        {"trace-file", required_argument, NULL, 'F'},
+        {"state-page", required_argument, NULL, 'M'},
+        {"gestures", required_argument, NULL, 'G'},
+        {"device-latency", required_argument, NULL, 'D'},
         {0, 0, 0, 0}
     };
     
@@ -103,14 +143,38 @@ int main(int argc, char** argv) {
     bool parseError = false;
     bool optionDebug = false;
     bool optionSimulate = false;
-    std::string optionHostname, optionInput, optionOutput;
-    while ((c = getopt_long(argc, argv, "hn:i:o:fds", long_options, &option_index)) != -1) {
+    int optionMetricsPort = 0;
+    int optionTempoInterval = 100;
+    int optionDeviceLatency = 0;
+    int optionMaxAge = 3000;
+    int optionConnectTimeout = 10000;
+    std::vector<std::string> optionHostnames;
+    std::string optionInput, optionOutput;
+    std::string optionStateFile = "/tmp/modmidi.state";
+    std::vector<ControllerOption> optionControllers;
+    ThruFilter optionThru;
+    int optionThruBudget = 32;
+    std::vector<ExpressionMapping> optionExpressions;
+    int optionExpressionRate = 30;
+    int optionExpressionSmoothing = 30;
+    int optionLinkRate = OutputShaper::MIDI_BYTES_PER_SECOND;
+    bool optionRunningStatus = false;
+    int optionResync = 1000;
+    std::string optionSession;
+    int optionSessions = 1;
+    unsigned int optionSeed = 1;
+    int optionJitter = 0;
+    bool optionLockMemory = false;
+    std::string optionTraceFile = "/tmp/modmidi-trace.json";
+    std::string optionStatePage = "/modmidi";
+    GestureTimes optionGestures;
+    while ((c = getopt_long(argc, argv, "hn:i:o:fdsm:t:a:c:S:C:T:b:e:E:g:l:ry:x:N:R:j:P:LF:M:G:D:", long_options, &option_index)) != -1) {
         switch(c) {
             case 'h':
                 optionHelp = true;
                 break;
             case 'n':
-                optionHostname = std::string(optarg);
+                optionHostnames.push_back(std::string(optarg));
                 break;
             case 'i':
                 optionInput = std::string(optarg);
@@ -126,6 +190,107 @@ int main(int argc, char** argv) {
                 break;
             case 's':
                 optionSimulate = true;
+                break;
+            case 'm':
+                optionMetricsPort = atoi(optarg);
+                break;
+            case 't':
+                optionTempoInterval = atoi(optarg);
+                break;
+            case 'a':
+                optionMaxAge = atoi(optarg);
+                break;
+            case 'c':
+                optionConnectTimeout = atoi(optarg);
+                break;
+            case 'S':
+                optionStateFile = std::string(optarg);
+                break;
+            case 'C': {
+                ControllerOption controller;
+                if (!parseController(std::string(optarg), controller)) {
+                    std::cout << "Invalid controller: " << optarg << std::endl;
+                    optionHelp = true;
+                    parseError = true;
+                    break;
+                }
+                optionControllers.push_back(controller);
+                break;
+            }
+            case 'T':
+                if (!optionThru.parse(std::string(optarg))) {
+                    std::cout << "Invalid thru types: " << optarg << std::endl;
+                    optionHelp = true;
+                    parseError = true;
+                }
+                break;
+            case 'b':
+                optionThruBudget = atoi(optarg);
+                break;
+            case 'e': {
+                ExpressionMapping mapping;
+                if (!mapping.parse(std::string(optarg))) {
+                    std::cout << "Invalid expression mapping: " << optarg << std::endl;
+                    optionHelp = true;
+                    parseError = true;
+                    break;
+                }
+                optionExpressions.push_back(mapping);
+                break;
+            }
+            case 'E':
+                optionExpressionRate = atoi(optarg);
+                break;
+            case 'g':
+                optionExpressionSmoothing = atoi(optarg);
+                break;
+            case 'l':
+                optionLinkRate = atoi(optarg);
+                break;
+            case 'r':
+                optionRunningStatus = true;
+                break;
+            case 'y':
+                optionResync = atoi(optarg);
+                break;
+            case 'x':
+                optionSession = std::string(optarg);
+                break;
+            case 'N':
+                optionSessions = atoi(optarg);
+                break;
+            case 'R':
+                optionSeed = (unsigned int)strtoul(optarg, NULL, 10);
+                break;
+            case 'j':
+                optionJitter = atoi(optarg);
+                break;
+            case 'P':
+                if (!threadPolicies().set(std::string(optarg))) {
+                    std::cout << "Invalid thread policy: " << optarg << std::endl;
+                    optionHelp = true;
+                    parseError = true;
+                }
+                break;
+            case 'L':
+                optionLockMemory = true;
+                break;
+            case 'F':
+                optionTraceFile = std::string(optarg);
+                break;
+            case 'M':
+                optionStatePage = std::string(optarg);
+                break;
+            case 'G':
+                if (!optionGestures.parse(std::string(optarg))) {
+                    std::cout << "Invalid gesture times: " << optarg << std::endl;
+                    optionHelp = true;
+                    parseError = true;
+                }
+                break;
+            case 'D':
+                optionDeviceLatency = atoi(optarg);
+                break;
             case '?':
                 optionHelp = true;
                 parseError = true;
@@ -143,12 +308,72 @@ int main(int argc, char** argv) {
         std::cout << std::endl;
         std::cout << "ModMidi command line options:" << std::endl << std::endl;
         std::cout << "    -h, --help           display this help information" << std::endl;
-        std::cout << "    -n, --hostname HOST  set the hostname of the Mod Duo" << std::endl;
+        std::cout << "    -n, --hostname HOST[@CONTROLLER,...]" << std::endl;
+        std::cout << "                         set the hostname of the Mod Duo, give it again for" << std::endl;
+        std::cout << "                         more units, optionally only for some controllers" << std::endl;
         std::cout << "    -i, --input PORT     jack midi input port to use (regex)" << std::endl;
         std::cout << "    -o, --output PORT    jack midi output port to use (regex)" << std::endl;
         std::cout << "    -f, --flash          enable flashing tempo light" << std::endl;
         std::cout << "    -d, --debug          print some debugging information" << std::endl;
         std::cout << "    -s, --simulate       pretend to connect to the Mod" << std::endl;
+        std::cout << "    -m, --metrics PORT   serve Prometheus metrics on localhost:PORT" << std::endl;
+        std::cout << "    -t, --tempo-interval MSEC" << std::endl;
+        std::cout << "                         minimum time between tempo updates (default 100)" << std::endl;
+        std::cout << "    -a, --max-age MSEC   drop presses the Mod couldn't handle in time (default 3000)" << std::endl;
+        std::cout << "    -c, --connect-timeout MSEC" << std::endl;
+        std::cout << "                         give up connecting to the Mod after this long (default 10000)" << std::endl;
+        std::cout << "    -S, --state-file FILE" << std::endl;
+        std::cout << "                         remember the Mod's state here for a quick restart," << std::endl;
+        std::cout << "                         empty to disable (default /tmp/modmidi.state)" << std::endl;
+        std::cout << "    -C, --controller NAME,INPUT,OUTPUT[,PROFILE]" << std::endl;
+        std::cout << "                         add a controller with its own ports (regexes), can be" << std::endl;
+        std::cout << "                         given more than once, replaces -i & -o" << std::endl;
+        std::cout << "                         profiles:";
+        for (auto &name : DeviceProfile::names()) std::cout << " " << name;
+        std::cout << " (default fcb1010)" << std::endl;
+        std::cout << "    -T, --thru TYPES     pass these input messages through to the output, any of" << std::endl;
+        std::cout << "                         " << ThruFilter::typeNames() << std::endl;
+        std::cout << "    -b, --thru-budget N  pass at most N messages through per jack cycle (default 32)" << std::endl;
+        std::cout << "    -e, --expression CC=PORT[:MIN:MAX]" << std::endl;
+        std::cout << "                         control a plugin parameter (e.g. /graph/ds1/level) with" << std::endl;
+        std::cout << "                         an expression pedal, can be given more than once" << std::endl;
+        std::cout << "    -E, --expression-rate N" << std::endl;
+        std::cout << "                         send each parameter at most N times a second (default 30)" << std::endl;
+        std::cout << "    -g, --expression-smoothing MSEC" << std::endl;
+        std::cout << "                         smooth expression pedals over this long (default 30)" << std::endl;
+        std::cout << "    -l, --link-rate BYTES" << std::endl;
+        std::cout << "                         bytes a second the controller's MIDI link can carry," << std::endl;
+        std::cout << "                         0 for no limit (default 3125, a MIDI DIN cable)" << std::endl;
+        std::cout << "    -r, --running-status use MIDI running status for output to the controllers," << std::endl;
+        std::cout << "                         only when ModMidi is the only client writing to a raw" << std::endl;
+        std::cout << "                         serial bridge like ttymidi" << std::endl;
+        std::cout << "    -y, --resync MSEC    with running status, send a full status byte at least" << std::endl;
+        std::cout << "                         this often, 0 for never (default 1000)" << std::endl;
+        std::cout << "    -x, --session FILE   play a scripted session against a simulated Mod on" << std::endl;
+        std::cout << "                         virtual time, without jack, then exit" << std::endl;
+        std::cout << "    -N, --sessions N     play the session N times (default 1)" << std::endl;
+        std::cout << "    -R, --seed N         seed for the first session, each one after adds 1 (default 1)" << std::endl;
+        std::cout << "    -j, --jitter MSEC    move each scripted press by up to +/- MSEC (default 0)" << std::endl;
+        std::cout << "    -P, --thread NAME=[POLICY][:PRIORITY][@CPUS]" << std::endl;
+        std::cout << "                         schedule a thread, e.g. worker=fifo:20@0, POLICY is" << std::endl;
+        std::cout << "                         other, fifo or rr, can be given more than once, threads:" << std::endl;
+        std::cout << "                        ";
+        for (auto &name : ThreadPolicies::names()) std::cout << " " << name;
+        std::cout << " all" << std::endl;
+        std::cout << "    -L, --lock-memory    lock ModMidi's memory so it never pages" << std::endl;
+        std::cout << "    -F, --trace-file FILE" << std::endl;
+        std::cout << "                         where SIGUSR1 writes the flight recorder as a Chrome" << std::endl;
+        std::cout << "                         trace (default /tmp/modmidi-trace.json)" << std::endl;
+        std::cout << "    -M, --state-page NAME" << std::endl;
+        std::cout << "                         publish the state in this POSIX shared memory page for" << std::endl;
+        std::cout << "                         other programs, empty to disable (default /modmidi)" << std::endl;
+        std::cout << "    -G, --gestures DOUBLE:LONG[:REPEAT]" << std::endl;
+        std::cout << "                         msec for a double tap, a long press & a hold repeat," << std::endl;
+        std::cout << "                         0 turns one off (default 300:600:250)" << std::endl;
+        std::cout << "    -D, --device-latency MSEC" << std::endl;
+        std::cout << "                         how long the controller takes to light up after ModMidi" << std::endl;
+        std::cout << "                         sends it MIDI, on top of jack's latency, the tempo light" << std::endl;
+        std::cout << "                         is sent that much early (default 0)" << std::endl;
         return parseError ? -1 : 0;
     }
     
@@ -158,64 +383,164 @@ int main(int argc, char** argv) {
     signal(SIGTERM, signal_handler);
     signal(SIGINT, signal_handler);
     
-    cout << "Starting ModMidi..." << endl;
+    // start the logging thread
+    logSetLevel(optionDebug ? LOG_LEVEL_DEBUG : LOG_LEVEL_INFO);
+    logStart();
     
+    LOG_INFO("Starting ModMidi...");
+    // before any of the other threads start, so their stacks get prefaulted
+    if (optionLockMemory && lockMemory()) threadPolicies().setPrefault(ThreadPolicies::PREFAULT_BYTES);
+
+    // scripted sessions don't need jack or a Mod
+    if (optionSession.size() > 0) {
+        Session session;
+        bool passed = session.load(optionSession);
+        if (passed) {
+            session.setJitter(optionJitter);
+            passed = session.runAll(optionSessions > 0 ? optionSessions : 1, optionSeed);
+        }
+        logStop();
+        return passed ? 0 : 1;
+    }
+
+    // SIGUSR1 writes out the flight recorder
+    flightRecorder().startDumper(optionTraceFile);
+    signal(SIGUSR1, dump_handler);
+
     // start up our Jack client
     client = jack_client_open("ModMidi", JackNoStartServer, NULL);
     if (!client) {
-        cout << "unable to connect to jack server" << endl;
+        LOG_ERROR("unable to connect to jack server");
+        logStop();
         return -1;
     }
 
     jack_set_process_callback(client, process, 0);
-    input_port = jack_port_register(client, "input", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
-    output_port = jack_port_register(client, "output", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+    jack_set_xrun_callback(client, xrun, 0);
+    jack_set_latency_callback(client, latency, 0);
+    // without --controller there's a single FCB1010 on the original ports
+    bool singleController = optionControllers.size() == 0;
+    if (singleController) {
+        ControllerOption controller;
+        controller.name = "fcb";
+        // the ports get connected whenever matching ports show up, so it's
+        // fine if ttymidi isn't running yet or restarts later
+        controller.input = optionInput.size() > 0 ? optionInput : "ttymidi:MIDI_in";
+        controller.output = optionOutput.size() > 0 ? optionOutput : "ttymidi:MIDI_out";
+        optionControllers.push_back(controller);
+    }
+    std::vector<DeviceProfile> profiles;
+    PortConnector portConnector(client);
+    for (auto &controller : optionControllers) {
+        DeviceProfile profile;
+        if (!DeviceProfile::find(controller.profile, profile)) {
+            LOG_ERROR("Unknown controller profile: %s", controller.profile.c_str());
+            jack_client_close(client);
+            logStop();
+            return -1;
+        }
+        profiles.push_back(profile);
+        string inputName = singleController ? "input" : controller.name + "_in";
+        string outputName = singleController ? "output" : controller.name + "_out";
+        controller.inputPort = jack_port_register(client, inputName.c_str(), JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+        controller.outputPort = jack_port_register(client, outputName.c_str(), JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+        if (!controller.inputPort || !controller.outputPort) {
+            LOG_ERROR("Unable to register ports for controller %s", controller.name.c_str());
+            jack_client_close(client);
+            logStop();
+            return -1;
+        }
+        if (!portConnector.addPort(controller.inputPort, controller.input) || !portConnector.addPort(controller.outputPort, controller.output)) {
+            jack_client_close(client);
+            logStop();
+            return -1;
+        }
+    }
+    portConnector.setCallbacks();
+    portConnector.setConnectedCallback([] (jack_port_t *port) {
+        // the controller may have lost its state, send it everything again
+        if (worker) worker->refreshLights(port);
+    });
     if (jack_activate(client)) {
-        cout << "unable to activate jack client" << endl;
+        LOG_ERROR("unable to activate jack client");
         jack_client_close(client);
+        logStop();
         return -1;
     }
-    // connect the ports
-    string inputPort = optionInput.size() > 0 ? optionInput : "ttymidi:MIDI_in";
-    string outputPort = optionOutput.size() > 0 ? optionOutput : "ttymidi:MIDI_out";
-    cout << "Attempting to connect to ports:" << endl << inputPort << endl << outputPort << endl;
-    bool connected = connectPorts(inputPort, outputPort);
-    if (!connected) {
-        cout << "Unable to connect ports." << endl;
-        jack_client_close(client);
-        return -1;
+    threadPolicies().apply("jack", jack_client_thread_id(client));
+    for (auto &controller : optionControllers) {
+        LOG_INFO("Attempting to connect controller %s to ports:\n%s\n%s", controller.name.c_str(), controller.input.c_str(), controller.output.c_str());
+    }
+    portConnector.start();
+    Worker *workerTemp = new Worker(client);
+    for (size_t i=0; i<optionControllers.size(); i++) {
+        ControllerOption &controller = optionControllers[i];
+        workerTemp->addController(controller.name, controller.inputPort, controller.outputPort, profiles[i]);
+    }
+    workerTemp->setThru(optionThru, optionThruBudget);
+    workerTemp->setLinkRate(optionLinkRate > 0 ? optionLinkRate : 0);
+    workerTemp->setRunningStatus(optionRunningStatus, optionResync);
+    workerTemp->setGestureTimes(optionGestures);
+    for (auto &mapping : optionExpressions) {
+        workerTemp->addExpression(mapping);
     }
-    Worker *workerTemp = new Worker(client, input_port, output_port);
-    if (optionHostname.size() > 0) {
-        cout << "Using Mod Duo hostname: " << optionHostname << endl;
-        workerTemp->setHostname(optionHostname);
-    } else {
-        cout << "Using Mod Duo hostname: localhost" << endl;
+    workerTemp->setExpressionRate(optionExpressionRate);
+    workerTemp->setExpressionSmoothing(optionExpressionSmoothing);
+    if (optionHostnames.size() == 0) optionHostnames.push_back("localhost");
+    for (auto &option : optionHostnames) {
+        size_t at = option.find('@');
+        std::string hostname = option.substr(0, at);
+        std::vector<std::string> routes;
+        if (at != std::string::npos) routes = splitString(option.substr(at + 1), ',');
+        LOG_INFO("Using Mod Duo hostname: %s", option.c_str());
+        workerTemp->addHost(hostname, routes);
     }
     workerTemp->setSimulate(optionSimulate);
     workerTemp->setDebug(optionDebug);
     workerTemp->setTempoLight(optionFlash);
-    if (!workerTemp->start()) {
-        cout << "Unable to start worker" << endl;
-        delete workerTemp;
-        cout << "Shutting down jack client..." << endl;
-        jack_client_close(client);
-        return -1;
+    workerTemp->setTempoInterval(optionTempoInterval);
+    workerTemp->setDeviceLatency(optionDeviceLatency);
+    workerTemp->setMaxAge(optionMaxAge);
+    workerTemp->setConnectTimeout(optionConnectTimeout);
+    if (optionStateFile.size() > 0 && workerTemp->setStateFile(optionStateFile)) {
+        workerTemp->restoreState();
     }
+    if (optionStatePage.size() > 0) workerTemp->setStatePage(optionStatePage);
+    // let jack show the cached state while we connect to the Mod
     worker = workerTemp;
     workerTemp = NULL;
+    // jack calls back again whenever the connections change
+    jack_recompute_total_latencies(client);
+    if (!worker->start()) {
+        LOG_ERROR("Unable to start worker");
+        portConnector.stop();
+        LOG_INFO("Shutting down jack client...");
+        // close the client first so the process callback is done with the worker
+        jack_client_close(client);
+        delete worker;
+        logStop();
+        return -1;
+    }
+    
+    MetricsServer metricsServer;
+    if (optionMetricsPort > 0) metricsServer.start(optionMetricsPort);
     
     // wait for the quit flag
     waitForQuit();
     
+    metricsServer.stop();
+    portConnector.stop();
+    
     if (client != NULL) {
-        cout << "Shutting down jack client..." << endl;
+        LOG_INFO("Shutting down jack client...");
         jack_client_close(client);
     }
 
     worker->stop();
     delete worker;
     
+    flightRecorder().stopDumper();
+    logStop();
     return 0;
 }
 
@@ -0,0 +1,627 @@
+/*
+ * File:   ModMock.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ *
+ * A stand-in for the Mod Duo's ModMidi command server (port 7777). It speaks
+ * the same newline terminated protocol as the customized mod-ui, so the real
+ * ModMidi client code can be exercised and benchmarked on localhost.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+using namespace std;
+
+// a latency distribution for one command, all values in milliseconds
+class Latency {
+public:
+    enum Type {
+        FIXED,
+        UNIFORM,
+        NORMAL,
+        EXPONENTIAL
+    };
+    Type type = FIXED;
+    double a = 0, b = 0;
+
+    bool parse(std::string spec);
+    double sample(std::mt19937 &rng);
+};
+
+bool Latency::parse(std::string spec) {
+    std::vector<std::string> parts;
+    size_t start = 0, pos;
+    while ((pos = spec.find(':', start)) != std::string::npos) {
+        parts.push_back(spec.substr(start, pos - start));
+        start = pos + 1;
+    }
+    parts.push_back(spec.substr(start));
+    try {
+        if (parts[0] == "fixed" && parts.size() == 2) {
+            type = FIXED;
+            a = std::stod(parts[1]);
+        } else if (parts[0] == "uniform" && parts.size() == 3) {
+            type = UNIFORM;
+            a = std::stod(parts[1]);
+            b = std::stod(parts[2]);
+        } else if (parts[0] == "normal" && parts.size() == 3) {
+            type = NORMAL;
+            a = std::stod(parts[1]);
+            b = std::stod(parts[2]);
+        } else if (parts[0] == "exp" && parts.size() == 2) {
+            type = EXPONENTIAL;
+            a = std::stod(parts[1]);
+        } else if (parts.size() == 1) {
+            type = FIXED;
+            a = std::stod(parts[0]);
+        } else {
+            return false;
+        }
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+double Latency::sample(std::mt19937 &rng) {
+    double value = a;
+    switch(type) {
+        case UNIFORM: {
+            std::uniform_real_distribution<double> d(a, b);
+            value = d(rng);
+            break;
+        }
+        case NORMAL: {
+            std::normal_distribution<double> d(a, b);
+            value = d(rng);
+            break;
+        }
+        case EXPONENTIAL: {
+            if (a <= 0) break;
+            std::exponential_distribution<double> d(1.0 / a);
+            value = d(rng);
+            break;
+        }
+        case FIXED:
+        default:
+            break;
+    }
+    return value < 0 ? 0 : value;
+}
+
+// mock server settings, set up once in main()
+static int optionPort = 7777;
+static int optionPedalboards = 16;
+static int optionBanks = 1;
+static int optionPresets = 3;
+static double optionDisconnect = 0;
+static int optionDisconnectAfter = 0;
+static double optionTruncate = 0;
+static size_t optionChunkSize = 0;
+static int optionChunkDelay = 0;
+static bool optionVerbose = false;
+static std::map<std::string, Latency> latencies;
+
+// simulated Mod state, protected by m_state
+static std::mutex m_state;
+static std::mt19937 rng;
+static int currentBank = 0;
+static int currentPedalboard = 0;
+static int currentPreset = 0;
+// every bank's pedalboards, bank by bank
+static std::vector<double> pedalboardBPMs;
+static std::map<std::string, std::deque<std::string>> transcript;
+static std::map<std::string, unsigned long> commandCounts;
+
+static std::atomic<bool> quit(false);
+static int listenSocket = -1;
+
+static void signal_handler(int sig) {
+    quit = true;
+    if (listenSocket >= 0) shutdown(listenSocket, SHUT_RDWR);
+}
+
+static std::string escapeJSON(const std::string &s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+// pull an integer field out of a small JSON argument like {"id": 3}
+static bool getNumberArgument(const std::string &data, const std::string &key, double &value) {
+    size_t pos = data.find("\"" + key + "\"");
+    if (pos == std::string::npos) return false;
+    pos = data.find(':', pos);
+    if (pos == std::string::npos) return false;
+    try {
+        value = std::stod(data.substr(pos + 1));
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+// the first bank keeps the names from before there were several
+static std::string pedalboardBundle(int bank, int i) {
+    if (bank == 0) return "/root/.pedalboards/mock-" + std::to_string(i + 1) + ".pedalboard";
+    return "/root/.pedalboards/mock-" + std::to_string(bank + 1) + "-" + std::to_string(i + 1) + ".pedalboard";
+}
+
+static std::string pedalboardTitle(int bank, int i) {
+    if (bank == 0) return "Mock pedalboard " + std::to_string(i + 1);
+    return "Mock bank " + std::to_string(bank + 1) + " pedalboard " + std::to_string(i + 1);
+}
+
+static std::string bankTitle(int bank) {
+    if (bank == 0) return "Mock bank";
+    return "Mock bank " + std::to_string(bank + 1);
+}
+
+// build a response from the simulated Mod state, called with m_state held
+static std::string modelResponse(const std::string &command, const std::string &data) {
+    double value;
+    if (command == "get_banks") {
+        std::string r = "{\"okay\": true, \"current\": " + std::to_string(currentBank) + ", \"banks\": [";
+        for (int i=0; i<optionBanks; i++) {
+            if (i > 0) r += ", ";
+            r += "{\"id\": " + std::to_string(i) + ", \"title\": \"" + escapeJSON(bankTitle(i)) + "\", ";
+            r += "\"count\": " + std::to_string(optionPedalboards) + "}";
+        }
+        return r + "]}";
+    }
+    if (command == "get_bank") {
+        // the current bank unless another is asked for
+        int bank = currentBank;
+        if (getNumberArgument(data, "id", value)) bank = (int)value;
+        if (bank < 0 || bank >= optionBanks) return "{\"okay\": false}";
+        std::string r = "{\"okay\": true, \"bank\": {\"title\": \"" + escapeJSON(bankTitle(bank)) + "\", \"pedalboards\": [";
+        for (int i=0; i<optionPedalboards; i++) {
+            if (i > 0) r += ", ";
+            r += "{\"title\": \"" + escapeJSON(pedalboardTitle(bank, i)) + "\", ";
+            r += "\"bundle\": \"" + escapeJSON(pedalboardBundle(bank, i)) + "\"}";
+        }
+        return r + "]}}";
+    }
+    if (command == "get_presets") {
+        std::string r = "{\"okay\": true, \"presets\": {";
+        for (int i=0; i<optionPresets; i++) {
+            if (i > 0) r += ", ";
+            r += "\"" + std::to_string(i) + "\": \"Preset " + std::to_string(i + 1) + "\"";
+        }
+        return r + "}}";
+    }
+    if (command == "get_pedalboard") {
+        return "{\"okay\": true, \"pedalboard\": {\"path\": \"" + escapeJSON(pedalboardBundle(currentBank, currentPedalboard)) +
+                "\", \"preset\": " + std::to_string(currentPreset) + "}}";
+    }
+    if (command == "get_bpm") {
+        return "{\"okay\": true, \"bpm\": " + std::to_string(pedalboardBPMs.at(currentBank * optionPedalboards + currentPedalboard)) + "}";
+    }
+    if (command == "set_bpm") {
+        if (!getNumberArgument(data, "bpm", value) || value <= 0) return "{\"okay\": false}";
+        pedalboardBPMs.at(currentBank * optionPedalboards + currentPedalboard) = value;
+        return "{\"okay\": true}";
+    }
+    if (command == "set_parameter") {
+        if (data.find("\"port\"") == std::string::npos || !getNumberArgument(data, "value", value)) return "{\"okay\": false}";
+        return "{\"okay\": true}";
+    }
+    if (command == "load_preset") {
+        if (!getNumberArgument(data, "id", value) || value < 0 || value >= optionPresets) return "{\"okay\": false}";
+        currentPreset = (int)value;
+        return "{\"okay\": true}";
+    }
+    if (command == "load_pedalboard") {
+        if (!getNumberArgument(data, "id", value) || value < 0 || value >= optionPedalboards) return "{\"okay\": false}";
+        // loading from another bank makes it the current bank
+        double bank = currentBank;
+        if (getNumberArgument(data, "bank", bank) && (bank < 0 || bank >= optionBanks)) return "{\"okay\": false}";
+        currentBank = (int)bank;
+        currentPedalboard = (int)value;
+        currentPreset = 0;
+        return "{\"okay\": true}";
+    }
+    return "{\"okay\": false, \"error\": \"unknown command\"}";
+}
+
+static bool writeAll(int socket, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(socket, data, length, MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        data += sent;
+        length -= sent;
+    }
+    return true;
+}
+
+// send a response, optionally in slow chunks
+static bool writeResponse(int socket, const std::string &response) {
+    if (optionChunkSize == 0) return writeAll(socket, response.c_str(), response.length());
+    for (size_t pos = 0; pos < response.length(); pos += optionChunkSize) {
+        size_t length = std::min(optionChunkSize, response.length() - pos);
+        if (!writeAll(socket, response.c_str() + pos, length)) return false;
+        if (optionChunkDelay > 0) std::this_thread::sleep_for(std::chrono::milliseconds(optionChunkDelay));
+    }
+    return true;
+}
+
+static void clientThread(int socket, std::string peer) {
+    std::cout << "client connected: " << peer << std::endl;
+    int flag = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    std::string buffer;
+    char chunk[4096];
+    int handled = 0;
+    bool open = true;
+    while (open && !quit) {
+        ssize_t bytes = recv(socket, chunk, sizeof(chunk), 0);
+        if (bytes <= 0) break;
+        buffer.append(chunk, bytes);
+        size_t pos;
+        while (open && (pos = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, pos);
+            buffer.erase(0, pos + 1);
+            std::string command = line, data;
+            size_t space = line.find(' ');
+            if (space != std::string::npos) {
+                command = line.substr(0, space);
+                data = line.substr(space + 1);
+            }
+
+            std::string response;
+            double delay = 0;
+            bool disconnect = false, truncate = false;
+            {
+                std::lock_guard<std::mutex> guard(m_state);
+                commandCounts[command]++;
+                auto latency = latencies.find(command);
+                if (latency != latencies.end()) delay = latency->second.sample(rng);
+                std::uniform_real_distribution<double> d(0, 1);
+                disconnect = optionDisconnect > 0 && d(rng) < optionDisconnect;
+                truncate = optionTruncate > 0 && d(rng) < optionTruncate;
+                // recorded responses take priority over the model
+                auto recorded = transcript.find(line);
+                if (recorded != transcript.end() && recorded->second.size() > 0) {
+                    response = recorded->second.front();
+                    recorded->second.pop_front();
+                } else {
+                    response = modelResponse(command, data);
+                }
+            }
+            handled++;
+            if (optionDisconnectAfter > 0 && handled >= optionDisconnectAfter) disconnect = true;
+            if (optionVerbose) std::cout << peer << " > " << line << std::endl;
+
+            if (delay > 0) std::this_thread::sleep_for(std::chrono::microseconds((long)(delay * 1000)));
+            if (disconnect) {
+                std::cout << "dropping connection " << peer << " on " << command << std::endl;
+                open = false;
+                break;
+            }
+            if (truncate) {
+                // send part of the response and hang up
+                writeAll(socket, response.c_str(), response.length() / 2);
+                std::cout << "truncated response to " << peer << " on " << command << std::endl;
+                open = false;
+                break;
+            }
+            if (optionVerbose) std::cout << peer << " < " << response << std::endl;
+            if (!writeResponse(socket, response + "\n")) open = false;
+        }
+    }
+    close(socket);
+    std::cout << "client disconnected: " << peer << std::endl;
+}
+
+// load a transcript of "> command" / "< response" line pairs
+static bool loadTranscript(std::string filename) {
+    std::ifstream file(filename);
+    if (!file) return false;
+    std::string line, command;
+    bool haveCommand = false;
+    unsigned int count = 0;
+    while (std::getline(file, line)) {
+        if (line.size() < 2) continue;
+        if (line.compare(0, 2, "> ") == 0) {
+            command = line.substr(2);
+            haveCommand = true;
+        } else if (line.compare(0, 2, "< ") == 0 && haveCommand) {
+            transcript[command].push_back(line.substr(2));
+            haveCommand = false;
+            count++;
+        }
+    }
+    std::cout << "loaded " << count << " recorded responses from " << filename << std::endl;
+    return true;
+}
+
+static int connectUpstream(std::string upstream) {
+    std::string host = upstream, port = "7777";
+    size_t pos = upstream.rfind(':');
+    if (pos != std::string::npos) {
+        host = upstream.substr(0, pos);
+        port = upstream.substr(pos + 1);
+    }
+    addrinfo hints, *infoptr;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &infoptr)) return -1;
+    int s = -1;
+    for (addrinfo *p = infoptr; p != NULL; p = p->ai_next) {
+        s = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        if (s < 0) continue;
+        if (connect(s, p->ai_addr, p->ai_addrlen) == 0) break;
+        close(s);
+        s = -1;
+    }
+    freeaddrinfo(infoptr);
+    return s;
+}
+
+// proxy one client to a real Mod, appending every exchange to a transcript
+static std::mutex m_record;
+static void recordThread(int socket, std::string upstream, std::ofstream *record) {
+    int modSocket = connectUpstream(upstream);
+    if (modSocket < 0) {
+        std::cout << "unable to connect to upstream " << upstream << std::endl;
+        close(socket);
+        return;
+    }
+    std::string clientBuffer, modBuffer;
+    char chunk[4096];
+    while (!quit) {
+        size_t pos;
+        while ((pos = clientBuffer.find('\n')) == std::string::npos) {
+            ssize_t bytes = recv(socket, chunk, sizeof(chunk), 0);
+            if (bytes <= 0) goto done;
+            clientBuffer.append(chunk, bytes);
+        }
+        std::string line = clientBuffer.substr(0, pos);
+        clientBuffer.erase(0, pos + 1);
+        if (!writeAll(modSocket, (line + "\n").c_str(), line.length() + 1)) break;
+        while ((pos = modBuffer.find('\n')) == std::string::npos) {
+            ssize_t bytes = recv(modSocket, chunk, sizeof(chunk), 0);
+            if (bytes <= 0) goto done;
+            modBuffer.append(chunk, bytes);
+        }
+        std::string response = modBuffer.substr(0, pos);
+        modBuffer.erase(0, pos + 1);
+        {
+            std::lock_guard<std::mutex> guard(m_record);
+            *record << "> " << line << "\n< " << response << std::endl;
+        }
+        if (!writeAll(socket, (response + "\n").c_str(), response.length() + 1)) break;
+    }
+done:
+    close(modSocket);
+    close(socket);
+}
+
+int main(int argc, char** argv) {
+
+    static struct option long_options[] = {
+        {"help", no_argument, NULL, 'h'},
+        {"port", required_argument, NULL, 'p'},
+        {"pedalboards", required_argument, NULL, 'b'},
+        {"banks", required_argument, NULL, 'B'},
+        {"presets", required_argument, NULL, 'r'},
+        {"latency", required_argument, NULL, 'l'},
+        {"chunk", required_argument, NULL, 'c'},
+        {"disconnect", required_argument, NULL, 'x'},
+        {"disconnect-after", required_argument, NULL, 'a'},
+        {"truncate", required_argument, NULL, 't'},
+        {"replay", required_argument, NULL, 'P'},
+        {"record", required_argument, NULL, 'R'},
+        {"upstream", required_argument, NULL, 'u'},
+        {"seed", required_argument, NULL, 's'},
+        {"verbose", no_argument, NULL, 'v'},
+        {0, 0, 0, 0}
+    };
+
+    // defaults match the delays the old --simulate mode used
+    latencies["get_banks"].parse("fixed:10");
+    latencies["get_bank"].parse("fixed:20");
+    latencies["get_presets"].parse("fixed:15");
+    latencies["get_pedalboard"].parse("fixed:15");
+    latencies["get_bpm"].parse("fixed:10");
+    latencies["set_bpm"].parse("fixed:20");
+    latencies["set_parameter"].parse("fixed:5");
+    latencies["load_preset"].parse("fixed:10");
+    latencies["load_pedalboard"].parse("fixed:1000");
+
+    int option_index = 0;
+    int c;
+    bool optionHelp = false;
+    bool parseError = false;
+    std::string optionReplay, optionRecord, optionUpstream;
+    unsigned int optionSeed = 1;
+    while ((c = getopt_long(argc, argv, "hp:b:B:r:l:c:x:a:t:P:R:u:s:v", long_options, &option_index)) != -1) {
+        std::string arg = optarg ? optarg : "";
+        size_t pos;
+        switch(c) {
+            case 'h':
+                optionHelp = true;
+                break;
+            case 'p':
+                optionPort = atoi(optarg);
+                break;
+            case 'b':
+                optionPedalboards = atoi(optarg);
+                break;
+            case 'B':
+                optionBanks = atoi(optarg);
+                break;
+            case 'r':
+                optionPresets = atoi(optarg);
+                break;
+            case 'l':
+                pos = arg.find('=');
+                if (pos == std::string::npos || !latencies[arg.substr(0, pos)].parse(arg.substr(pos + 1))) {
+                    std::cout << "Invalid latency: " << arg << std::endl;
+                    optionHelp = parseError = true;
+                }
+                break;
+            case 'c':
+                pos = arg.find(':');
+                optionChunkSize = atoi(arg.substr(0, pos).c_str());
+                if (pos != std::string::npos) optionChunkDelay = atoi(arg.substr(pos + 1).c_str());
+                break;
+            case 'x':
+                optionDisconnect = atof(optarg);
+                break;
+            case 'a':
+                optionDisconnectAfter = atoi(optarg);
+                break;
+            case 't':
+                optionTruncate = atof(optarg);
+                break;
+            case 'P':
+                optionReplay = arg;
+                break;
+            case 'R':
+                optionRecord = arg;
+                break;
+            case 'u':
+                optionUpstream = arg;
+                break;
+            case 's':
+                optionSeed = atoi(optarg);
+                break;
+            case 'v':
+                optionVerbose = true;
+                break;
+            case '?':
+                optionHelp = true;
+                parseError = true;
+                break;
+        }
+    }
+    if (optind < argc) {
+        std::cout << "Unexpected arguments found." << std::endl;
+        optionHelp = true;
+        parseError = true;
+    }
+    if (optionPedalboards < 1 || optionBanks < 1 || optionPresets < 0 || (optionRecord.size() > 0) != (optionUpstream.size() > 0)) {
+        optionHelp = true;
+        parseError = true;
+    }
+
+    if (optionHelp) {
+        // display help information
+        std::cout << std::endl;
+        std::cout << "ModMidiMock command line options:" << std::endl << std::endl;
+        std::cout << "    -h, --help                display this help information" << std::endl;
+        std::cout << "    -p, --port PORT           port to listen on (default 7777)" << std::endl;
+        std::cout << "    -b, --pedalboards N       pedalboards in each bank (default 16)" << std::endl;
+        std::cout << "    -B, --banks N             number of banks (default 1)" << std::endl;
+        std::cout << "    -r, --presets N           presets per pedalboard (default 3)" << std::endl;
+        std::cout << "    -l, --latency CMD=DIST    response latency in msec for a command, where DIST is" << std::endl;
+        std::cout << "                              fixed:MS, uniform:MIN:MAX, normal:MEAN:SD or exp:MEAN" << std::endl;
+        std::cout << "    -c, --chunk BYTES[:MS]    write responses in chunks, sleeping between them" << std::endl;
+        std::cout << "    -x, --disconnect P        drop the connection with probability P per command" << std::endl;
+        std::cout << "    -a, --disconnect-after N  drop each connection after N commands" << std::endl;
+        std::cout << "    -t, --truncate P          send half a response and hang up with probability P" << std::endl;
+        std::cout << "    -P, --replay FILE         answer from a recorded transcript when possible" << std::endl;
+        std::cout << "    -R, --record FILE         record a transcript while proxying to --upstream" << std::endl;
+        std::cout << "    -u, --upstream HOST[:PORT] real Mod to proxy to when recording" << std::endl;
+        std::cout << "    -s, --seed N              random seed for latencies and faults" << std::endl;
+        std::cout << "    -v, --verbose             print every command and response" << std::endl;
+        return parseError ? -1 : 0;
+    }
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    rng.seed(optionSeed);
+    pedalboardBPMs.assign(optionBanks * optionPedalboards, 120.0);
+    if (optionReplay.size() > 0 && !loadTranscript(optionReplay)) {
+        std::cout << "Unable to read transcript " << optionReplay << std::endl;
+        return -1;
+    }
+    std::ofstream record;
+    if (optionRecord.size() > 0) {
+        record.open(optionRecord, std::ios::app);
+        if (!record) {
+            std::cout << "Unable to open " << optionRecord << " for recording" << std::endl;
+            return -1;
+        }
+    }
+
+    listenSocket = socket(AF_INET6, SOCK_STREAM, 0);
+    if (listenSocket < 0) {
+        std::cout << "Could not create socket" << std::endl;
+        return -1;
+    }
+    int flag = 1, off = 0;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+    setsockopt(listenSocket, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    sockaddr_in6 address;
+    memset(&address, 0, sizeof(address));
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(optionPort);
+    if (bind(listenSocket, (sockaddr *)&address, sizeof(address)) < 0 || listen(listenSocket, 16) < 0) {
+        std::cout << "Unable to listen on port " << optionPort << ": " << strerror(errno) << std::endl;
+        close(listenSocket);
+        return -1;
+    }
+    std::cout << "ModMidiMock listening on port " << optionPort << " with " << optionBanks << " bank(s) of " << optionPedalboards << " pedalboards" << std::endl;
+
+    while (!quit) {
+        sockaddr_in6 peerAddress;
+        socklen_t length = sizeof(peerAddress);
+        int s = accept(listenSocket, (sockaddr *)&peerAddress, &length);
+        if (s < 0) {
+            if (quit) break;
+            if (errno == EINTR) continue;
+            // e.g. out of file descriptors, give the clients a moment to close
+            // some rather than spinning on the same error
+            std::cout << "Unable to accept a connection: " << strerror(errno) << std::endl;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        char host[256] = "?";
+        char port[16] = "?";
+        getnameinfo((sockaddr *)&peerAddress, length, host, sizeof(host), port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV);
+        std::string peer = std::string(host) + ":" + port;
+        if (record.is_open()) {
+            std::thread(recordThread, s, optionUpstream, &record).detach();
+        } else {
+            std::thread(clientThread, s, peer).detach();
+        }
+    }
+    close(listenSocket);
+
+    std::lock_guard<std::mutex> guard(m_state);
+    std::cout << "Commands handled:" << std::endl;
+    for (auto &i : commandCounts) {
+        std::cout << i.first << ": " << i.second << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,559 @@
+/*
+ * File:   Soak.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ *
+ * Soak test for a running ModMidi, end to end: footswitch presses go into
+ * ModMidi's input through jack, ModMidi sends them to the Mod (normally
+ * ModMidiMock on localhost), and each press is timed until its light comes
+ * back on ModMidi's output and stops blinking. Presses are random at a given
+ * rate, or a session script (the same format as ModMidi --session) played
+ * over and over. Every so often it prints throughput, latency percentiles for
+ * each kind of press, error counts, and the memory & file descriptors used by
+ * ModMidi & the mock, so leaks and slow tails show up before a gig.
+ *
+ *   $ ./ModMidiMock &
+ *   $ ./ModMidi --hostname localhost --input ModMidiSoak:out --output ModMidiSoak:in &
+ *   $ ./ModMidiSoak --rate 5 --duration 7200
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <csignal>
+#include <getopt.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <jack/jack.h>
+#include <jack/midiport.h>
+
+// CC104 values 1-5 are the preset switches, 6-9 & 0 the pedalboard switches,
+// and the FCB1010 lights use the same numbers for the pedals
+static const int PEDALS = 10;
+static const int TAP_TEMPO = 11;
+// a pending light blinks every 125 msec, no change for this long means it's
+// settled
+static const int SETTLE_MSEC = 300;
+// latencies are counted in 1 msec buckets, the last is anything slower
+static const int HISTOGRAM_MSEC = 10000;
+
+enum Kind {
+    PRESET,
+    PEDALBOARD,
+    OTHER,
+    KINDS
+};
+static const char *kindNames[KINDS] = {"preset", "pedalboard", "other"};
+
+class Stats {
+public:
+    std::atomic<uint64_t> presses{0};
+    // the light came on and stayed on
+    std::atomic<uint64_t> settled{0};
+    // the light went out again, ModMidi rolled the press back
+    std::atomic<uint64_t> rejected{0};
+    // nothing settled in time
+    std::atomic<uint64_t> timeouts{0};
+    // a later press replaced this one before it settled
+    std::atomic<uint64_t> superseded{0};
+    std::atomic<uint32_t> histogram[HISTOGRAM_MSEC + 1];
+    std::atomic<uint32_t> maximum{0};
+    Stats() {
+        for (auto &h : histogram) h = 0;
+    }
+    void observe(uint32_t msec) {
+        histogram[msec < HISTOGRAM_MSEC ? msec : HISTOGRAM_MSEC]++;
+        uint32_t m = maximum;
+        while (msec > m && !maximum.compare_exchange_weak(m, msec));
+        settled++;
+    }
+    // the latency below which this fraction of the settled presses were
+    double percentile(double fraction) {
+        uint64_t total = 0;
+        for (auto &h : histogram) total += h;
+        if (total == 0) return 0;
+        uint64_t target = (uint64_t)(fraction * total);
+        uint64_t seen = 0;
+        for (int i=0; i<=HISTOGRAM_MSEC; i++) {
+            seen += histogram[i];
+            if (seen > target) return i;
+        }
+        return HISTOGRAM_MSEC;
+    }
+};
+static Stats stats[KINDS];
+
+class ScriptStep {
+public:
+    int msec;
+    int value;
+    bool release;
+};
+
+// a press waiting for its light, only used on the jack thread
+class Pending {
+public:
+    bool active = false;
+    Kind kind = OTHER;
+    uint64_t pressed = 0;
+    uint64_t lastChange = 0;
+    bool seen = false;
+    bool on = false;
+};
+
+// set up before jack is activated, then only used on the jack thread
+static jack_port_t *inputPort, *outputPort;
+static jack_nframes_t sampleRate = 48000;
+static uint64_t settleFrames, timeoutFrames;
+static Pending pending[PEDALS];
+static std::mt19937 rng;
+static std::vector<ScriptStep> script;
+static int scriptLength = 0;
+static size_t scriptNext = 0;
+static uint64_t scriptStart = 0;
+static double rate = 2;
+static int presetSwitches = 3, pedalboardSwitches = 5;
+static int weights[3] = {4, 1, 1};
+static uint64_t nextPress = 0;
+static bool started = false;
+// jack's frame time wraps after a day at 48kHz, soaks can run longer
+static jack_nframes_t lastFrameTime = 0;
+static uint64_t frames = 0;
+static unsigned char runningStatus = 0;
+
+static std::atomic<bool> quit{false};
+
+static void signal_handler(int sig) {
+    quit = true;
+}
+
+static Kind kindOf(int value) {
+    if (value >= 1 && value <= 5) return PRESET;
+    if (value >= 0 && value <= 9) return PEDALBOARD;
+    return OTHER;
+}
+
+static void press(void *buffer, jack_nframes_t time, uint64_t frame, int value, bool release) {
+    unsigned char data[3] = {0xb0, (unsigned char)(release ? 105 : 104), (unsigned char)value};
+    if (jack_midi_event_write(buffer, time, data, 3) != 0 || release) return;
+    Kind kind = kindOf(value);
+    stats[kind].presses++;
+    if (kind == OTHER) return;
+    // a pedalboard load drops waiting preset loads, and newer presses of the
+    // same kind replace older ones
+    for (int i=0; i<PEDALS; i++) {
+        if (!pending[i].active) continue;
+        if (pending[i].kind == kind || (kind == PEDALBOARD && pending[i].kind == PRESET) || i == value) {
+            pending[i].active = false;
+            stats[pending[i].kind].superseded++;
+        }
+    }
+    Pending &p = pending[value];
+    p.active = true;
+    p.kind = kind;
+    p.pressed = frame;
+    p.lastChange = frame;
+    p.seen = false;
+    p.on = false;
+}
+
+// the next random press, presses come as a poisson process at the rate
+static int randomSwitch() {
+    int pick = std::uniform_int_distribution<int>(0, weights[0] + weights[1] + weights[2] - 1)(rng);
+    if (pick < weights[0]) return std::uniform_int_distribution<int>(1, presetSwitches)(rng);
+    if (pick < weights[0] + weights[1]) {
+        int i = std::uniform_int_distribution<int>(0, pedalboardSwitches - 1)(rng);
+        return i == 4 ? 0 : i + 6;
+    }
+    return TAP_TEMPO;
+}
+
+static int process(jack_nframes_t nframes, void *arg) {
+    jack_nframes_t frameTime = jack_last_frame_time((jack_client_t *)arg);
+    frames += (jack_nframes_t)(frameTime - lastFrameTime);
+    lastFrameTime = frameTime;
+    uint64_t cycleStart = frames;
+    uint64_t cycleEnd = cycleStart + nframes;
+    if (!started) {
+        started = true;
+        frames = cycleStart = 0;
+        cycleEnd = nframes;
+        nextPress = cycleStart + sampleRate;
+        scriptStart = nextPress;
+    }
+
+    // the lights coming back from ModMidi, running status allowed
+    void *inBuffer = jack_port_get_buffer(inputPort, nframes);
+    jack_nframes_t count = jack_midi_get_event_count(inBuffer);
+    for (jack_nframes_t i=0; i<count; i++) {
+        jack_midi_event_t e;
+        if (jack_midi_event_get(&e, inBuffer, i) != 0 || e.size == 0) continue;
+        const unsigned char *data = e.buffer;
+        size_t size = e.size;
+        unsigned char status = runningStatus;
+        if (data[0] & 0x80) {
+            status = data[0];
+            if (status < 0xf0) runningStatus = status;
+            data++;
+            size--;
+        }
+        if ((status & 0xf0) != 0xb0 || size < 2) continue;
+        if (data[0] != 106 && data[0] != 107) continue;
+        int pedal = data[1];
+        if (pedal >= PEDALS || !pending[pedal].active) continue;
+        pending[pedal].seen = true;
+        pending[pedal].on = data[0] == 106;
+        pending[pedal].lastChange = cycleStart + e.time;
+    }
+
+    // the presses due this cycle
+    void *outBuffer = jack_port_get_buffer(outputPort, nframes);
+    jack_midi_clear_buffer(outBuffer);
+    if (script.size() > 0) {
+        while (true) {
+            if (scriptNext == script.size()) {
+                scriptNext = 0;
+                scriptStart += (uint64_t)scriptLength * sampleRate / 1000;
+            }
+            const ScriptStep &step = script[scriptNext];
+            uint64_t frame = scriptStart + (uint64_t)step.msec * sampleRate / 1000;
+            if (frame >= cycleEnd) break;
+            if (frame < cycleStart) frame = cycleStart;
+            press(outBuffer, frame - cycleStart, frame, step.value, step.release);
+            scriptNext++;
+        }
+    } else {
+        while (nextPress < cycleEnd) {
+            uint64_t frame = nextPress < cycleStart ? cycleStart : nextPress;
+            press(outBuffer, frame - cycleStart, frame, randomSwitch(), false);
+            double wait = std::exponential_distribution<double>(rate)(rng);
+            nextPress += 1 + (uint64_t)(wait * sampleRate);
+        }
+    }
+
+    // settle, reject or time out the presses still waiting
+    for (int i=0; i<PEDALS; i++) {
+        Pending &p = pending[i];
+        if (!p.active) continue;
+        if (p.seen && cycleEnd - p.lastChange >= settleFrames) {
+            p.active = false;
+            if (p.on) {
+                stats[p.kind].observe((uint32_t)((p.lastChange - p.pressed) * 1000 / sampleRate));
+            } else {
+                stats[p.kind].rejected++;
+            }
+        } else if (cycleEnd - p.pressed >= timeoutFrames) {
+            p.active = false;
+            stats[p.kind].timeouts++;
+        }
+    }
+    return 0;
+}
+
+static bool loadScript(std::string filename) {
+    std::ifstream in(filename);
+    if (!in) {
+        std::cerr << "Unable to open " << filename << std::endl;
+        return false;
+    }
+    std::string text;
+    int line = 0;
+    while (std::getline(in, text)) {
+        line++;
+        size_t comment = text.find('#');
+        if (comment != std::string::npos) text.erase(comment);
+        if (text.find_first_not_of(" \t\r") == std::string::npos) continue;
+        char action[16] = "";
+        int msec, value;
+        if (sscanf(text.c_str(), " at %d %15s", &msec, action) != 2 || msec < 0) {
+            std::cerr << filename << ":" << line << ": expected \"at MSEC ...\"" << std::endl;
+            return false;
+        }
+        scriptLength = std::max(scriptLength, msec);
+        // expectations only make sense against the simulated Mod
+        if (strcmp(action, "expect") == 0) continue;
+        bool release = strcmp(action, "release") == 0;
+        if ((!release && strcmp(action, "press") != 0) || sscanf(text.c_str(), " at %*d %*s %d", &value) != 1 || value < 0 || value > 127) {
+            std::cerr << filename << ":" << line << ": unknown step" << std::endl;
+            return false;
+        }
+        ScriptStep step;
+        step.msec = msec;
+        step.value = value;
+        step.release = release;
+        script.push_back(step);
+    }
+    std::stable_sort(script.begin(), script.end(), [](const ScriptStep &a, const ScriptStep &b) {return a.msec < b.msec;});
+    // leave a gap before it starts over
+    scriptLength += 1000;
+    return script.size() > 0;
+}
+
+// memory & file descriptors of one process, from /proc
+class ProcessUsage {
+public:
+    std::string name;
+    int pid = -1;
+    long rssKB = 0, fds = 0;
+    long startRssKB = 0, startFds = 0;
+    bool sample();
+};
+
+static int findProcess(const std::string &name) {
+    DIR *dir = opendir("/proc");
+    if (!dir) return -1;
+    int found = -1;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int pid = atoi(entry->d_name);
+        if (pid <= 0) continue;
+        std::ifstream comm("/proc/" + std::string(entry->d_name) + "/comm");
+        std::string text;
+        // the kernel keeps 15 characters of the name
+        if (std::getline(comm, text) && text == name.substr(0, 15)) {
+            found = pid;
+            break;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+bool ProcessUsage::sample() {
+    int current = findProcess(name);
+    if (current < 0) return false;
+    std::string proc = "/proc/" + std::to_string(current);
+    std::ifstream status(proc + "/status");
+    std::string text;
+    long rss = 0;
+    while (std::getline(status, text)) {
+        if (text.compare(0, 6, "VmRSS:") == 0) rss = atol(text.c_str() + 6);
+    }
+    long count = 0;
+    DIR *dir = opendir((proc + "/fd").c_str());
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] != '.') count++;
+        }
+        closedir(dir);
+    }
+    // a restart starts the counts over
+    if (current != pid) {
+        if (pid >= 0) printf("  %s restarted, pid %d is now %d\n", name.c_str(), pid, current);
+        pid = current;
+        startRssKB = rss;
+        startFds = count;
+    }
+    rssKB = rss;
+    fds = count;
+    return true;
+}
+
+static void report(double elapsed, std::vector<ProcessUsage> &processes) {
+    uint64_t presses = 0, errors = 0;
+    for (auto &s : stats) {
+        presses += s.presses;
+        errors += s.rejected + s.timeouts;
+    }
+    int seconds = (int)elapsed;
+    printf("%02d:%02d:%02d  %llu presses (%.2f/s), %llu errors (%.2f%%)\n", seconds / 3600, seconds / 60 % 60, seconds % 60,
+            (unsigned long long)presses, elapsed > 0 ? presses / elapsed : 0.0, (unsigned long long)errors, presses > 0 ? 100.0 * errors / presses : 0.0);
+    for (int k=0; k<KINDS; k++) {
+        Stats &s = stats[k];
+        if (s.presses == 0) continue;
+        if (k == OTHER) {
+            printf("  %-11s  %llu presses, not timed\n", kindNames[k], (unsigned long long)s.presses.load());
+            continue;
+        }
+        printf("  %-11s  %llu settled  p50 %.0f  p90 %.0f  p99 %.0f  p99.9 %.0f  max %u ms  %llu rejected  %llu timeouts  %llu superseded\n", kindNames[k],
+                (unsigned long long)s.settled.load(), s.percentile(0.5), s.percentile(0.9), s.percentile(0.99), s.percentile(0.999), s.maximum.load(),
+                (unsigned long long)s.rejected.load(), (unsigned long long)s.timeouts.load(), (unsigned long long)s.superseded.load());
+    }
+    for (auto &p : processes) {
+        if (!p.sample()) {
+            printf("  %-11s  not running\n", p.name.c_str());
+            continue;
+        }
+        printf("  %-11s  pid %d  rss %ld kB (%+ld)  %ld fds (%+ld)\n", p.name.c_str(), p.pid, p.rssKB, p.rssKB - p.startRssKB, p.fds, p.fds - p.startFds);
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"help", no_argument, NULL, 'h'},
+        {"input", required_argument, NULL, 'i'},
+        {"output", required_argument, NULL, 'o'},
+        {"rate", required_argument, NULL, 'r'},
+        {"mix", required_argument, NULL, 'm'},
+        {"presets", required_argument, NULL, 'p'},
+        {"pedalboards", required_argument, NULL, 'b'},
+        {"script", required_argument, NULL, 'x'},
+        {"duration", required_argument, NULL, 'd'},
+        {"report", required_argument, NULL, 'R'},
+        {"timeout", required_argument, NULL, 't'},
+        {"seed", required_argument, NULL, 's'},
+        {"watch", required_argument, NULL, 'w'},
+        {0, 0, 0, 0}
+    };
+    std::string modInput = "ModMidi:input", modOutput = "ModMidi:output";
+    int duration = 0, reportInterval = 60, timeoutMsec = 5000;
+    unsigned int seed = 1;
+    std::vector<ProcessUsage> processes;
+    bool help = false, parseError = false;
+    int c;
+    while ((c = getopt_long(argc, argv, "hi:o:r:m:p:b:x:d:R:t:s:w:", long_options, NULL)) != -1) {
+        switch(c) {
+            case 'i':
+                modInput = std::string(optarg);
+                break;
+            case 'o':
+                modOutput = std::string(optarg);
+                break;
+            case 'r':
+                rate = atof(optarg);
+                break;
+            case 'm':
+                if (sscanf(optarg, "%d:%d:%d", &weights[0], &weights[1], &weights[2]) != 3 || weights[0] < 0 || weights[1] < 0 || weights[2] < 0 || weights[0] + weights[1] + weights[2] == 0) {
+                    std::cout << "Invalid mix: " << optarg << std::endl;
+                    help = parseError = true;
+                }
+                break;
+            case 'p':
+                presetSwitches = atoi(optarg);
+                break;
+            case 'b':
+                pedalboardSwitches = atoi(optarg);
+                break;
+            case 'x':
+                if (!loadScript(std::string(optarg))) help = parseError = true;
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            case 'R':
+                reportInterval = atoi(optarg);
+                break;
+            case 't':
+                timeoutMsec = atoi(optarg);
+                break;
+            case 's':
+                seed = (unsigned int)strtoul(optarg, NULL, 10);
+                break;
+            case 'w': {
+                ProcessUsage p;
+                p.name = std::string(optarg);
+                processes.push_back(p);
+                break;
+            }
+            default:
+                help = true;
+                parseError = c != 'h';
+                break;
+        }
+    }
+    if (rate <= 0 || presetSwitches < 1 || presetSwitches > 5 || pedalboardSwitches < 1 || pedalboardSwitches > 5 || reportInterval < 1) {
+        std::cout << "Invalid options" << std::endl;
+        help = parseError = true;
+    }
+    if (help) {
+        std::cout << "ModMidiSoak command line options:" << std::endl << std::endl;
+        std::cout << "    -h, --help              display this help information" << std::endl;
+        std::cout << "    -i, --input PORT        ModMidi's input port (default ModMidi:input)" << std::endl;
+        std::cout << "    -o, --output PORT       ModMidi's output port (default ModMidi:output)" << std::endl;
+        std::cout << "    -r, --rate N            random presses a second (default 2)" << std::endl;
+        std::cout << "    -m, --mix P:B:T         weights of preset, pedalboard & tap presses (default 4:1:1)" << std::endl;
+        std::cout << "    -p, --presets N         use the first N preset switches (default 3)" << std::endl;
+        std::cout << "    -b, --pedalboards N     use the first N pedalboard switches (default 5)" << std::endl;
+        std::cout << "    -x, --script FILE       play a session script over & over instead" << std::endl;
+        std::cout << "    -d, --duration SEC      stop after this long, 0 to run until killed (default 0)" << std::endl;
+        std::cout << "    -R, --report SEC        print the results this often (default 60)" << std::endl;
+        std::cout << "    -t, --timeout MSEC      a press whose light hasn't settled by now is an error" << std::endl;
+        std::cout << "                            (default 5000)" << std::endl;
+        std::cout << "    -s, --seed N            seed for the random presses (default 1)" << std::endl;
+        std::cout << "    -w, --watch NAME        report the memory & fds of this process, can be given" << std::endl;
+        std::cout << "                            more than once (default ModMidi & ModMidiMock)" << std::endl;
+        return parseError ? -1 : 0;
+    }
+    if (processes.size() == 0) {
+        for (const char *name : {"ModMidi", "ModMidiMock"}) {
+            ProcessUsage p;
+            p.name = name;
+            processes.push_back(p);
+        }
+    }
+    rng.seed(seed);
+
+    jack_client_t *client = jack_client_open("ModMidiSoak", JackNoStartServer, NULL);
+    if (!client) {
+        std::cerr << "Unable to connect to jack" << std::endl;
+        return -1;
+    }
+    sampleRate = jack_get_sample_rate(client);
+    settleFrames = (uint64_t)SETTLE_MSEC * sampleRate / 1000;
+    timeoutFrames = (uint64_t)timeoutMsec * sampleRate / 1000;
+    inputPort = jack_port_register(client, "in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+    outputPort = jack_port_register(client, "out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+    if (!inputPort || !outputPort) {
+        std::cerr << "Unable to register ports" << std::endl;
+        jack_client_close(client);
+        return -1;
+    }
+    jack_set_process_callback(client, process, client);
+    if (jack_activate(client) != 0) {
+        std::cerr << "Unable to activate jack client" << std::endl;
+        jack_client_close(client);
+        return -1;
+    }
+    // fine if they're connected already, e.g. by ModMidi
+    jack_connect(client, jack_port_name(outputPort), modInput.c_str());
+    jack_connect(client, modOutput.c_str(), jack_port_name(inputPort));
+    if (!jack_port_connected(inputPort) || !jack_port_connected(outputPort)) {
+        std::cerr << "Unable to connect to " << modInput << " & " << modOutput << ", is ModMidi running?" << std::endl;
+        jack_client_close(client);
+        return -1;
+    }
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    for (auto &p : processes) {
+        p.sample();
+    }
+    if (script.size() > 0) {
+        printf("playing %u steps every %.1f s\n", (unsigned int)script.size(), scriptLength / 1000.0);
+    } else {
+        printf("%.2f presses a second, mix %d:%d:%d\n", rate, weights[0], weights[1], weights[2]);
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto nextReport = start + std::chrono::seconds(reportInterval);
+    while (!quit) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        if (duration > 0 && elapsed >= duration) break;
+        if (now >= nextReport) {
+            report(elapsed, processes);
+            nextReport += std::chrono::seconds(reportInterval);
+        }
+    }
+    jack_deactivate(client);
+    jack_client_close(client);
+    printf("\nfinal\n");
+    report(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), processes);
+    uint64_t errors = 0;
+    for (auto &s : stats) {
+        errors += s.rejected + s.timeouts;
+    }
+    return errors > 0 ? 1 : 0;
+}
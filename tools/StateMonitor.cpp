@@ -0,0 +1,88 @@
+/*
+ * File:   StateMonitor.cpp
+ * Author: caleb
+ *
+ * Created on October 18, 2026
+ *
+ * Prints the state ModMidi publishes in shared memory, and shows how to read
+ * it. Reading never makes a syscall or holds up ModMidi.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "StatePage.h"
+
+static void print(const StatePageData &state, uint64_t now) {
+    if (!state.running) printf("ModMidi isn't running, last known state:\n");
+    printf("pedalboard %d: %s\n", state.pedalboard, state.pedalboardTitle);
+    printf("preset %d: %s\n", state.preset, state.presetTitle);
+    printf("bank: %u pedalboards from %u, %u presets\n", state.pedalboardCount, state.pedalboardOffset, state.presetCount);
+    for (int i=0; i<StatePageData::SWITCHES; i++) {
+        printf("  switch %d: %s\n", i + 1, state.switchTitles[i]);
+    }
+    double phase = statePageBeatPhase(state, now);
+    if (phase >= 0) {
+        printf("bpm %.2f, beat %.2f\n", state.bpm, phase);
+    } else {
+        printf("bpm %.2f, paused\n", state.bpm);
+    }
+    if (state.statusTime > 0) {
+        printf("%u Mod(s), last status update %s, %.1f s ago\n", state.hosts, state.statusOk ? "ok" : "failed", (now - state.statusTime) / 1e9);
+    } else {
+        printf("%u Mod(s), no status update yet\n", state.hosts);
+    }
+}
+
+int main(int argc, char** argv) {
+    static struct option long_options[] = {
+        {"help", no_argument, NULL, 'h'},
+        {"name", required_argument, NULL, 'n'},
+        {"watch", no_argument, NULL, 'w'},
+        {0, 0, 0, 0}
+    };
+    std::string name = "/modmidi";
+    bool watch = false;
+    int c;
+    while ((c = getopt_long(argc, argv, "hn:w", long_options, NULL)) != -1) {
+        switch(c) {
+            case 'n':
+                name = std::string(optarg);
+                break;
+            case 'w':
+                watch = true;
+                break;
+            default:
+                std::cout << "ModMidiMonitor command line options:" << std::endl << std::endl;
+                std::cout << "    -h, --help           display this help information" << std::endl;
+                std::cout << "    -n, --name NAME      shared memory page to read (default /modmidi)" << std::endl;
+                std::cout << "    -w, --watch          keep printing whenever the state changes" << std::endl;
+                return c == 'h' ? 0 : -1;
+        }
+    }
+    const StatePageData *page = statePageOpen(name.c_str());
+    if (!page) {
+        std::cerr << "Unable to open " << name << ", is ModMidi running with --state-page?" << std::endl;
+        return -1;
+    }
+    StatePageData state;
+    if (!statePageRead(page, state)) {
+        std::cerr << name << " isn't a ModMidi state page, it's from a different version, or ModMidi died while writing it" << std::endl;
+        return -1;
+    }
+    print(state, statePageNow());
+    if (!watch) return 0;
+    uint64_t lastUpdate = state.updateTime;
+    while (true) {
+        usleep(50000);
+        if (!statePageRead(page, state) || state.updateTime == lastUpdate) continue;
+        lastUpdate = state.updateTime;
+        printf("\n");
+        print(state, statePageNow());
+        fflush(stdout);
+    }
+}